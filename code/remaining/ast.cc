@@ -1,15 +1,164 @@
+#include <iostream>
 #include "ast.hh"
 
 
+/*****************************
+ *** The AST arena methods ***
+ *****************************/
+
+thread_local ast_arena *ast_arena::current_arena = NULL;
+ast_arena ast_arena::default_arena;
+atomic<long> ast_arena::total_objects(0);
+atomic<long> ast_arena::total_bytes(0);
+atomic<long> ast_arena::live_bytes(0);
+atomic<long> ast_arena::heap_bytes(0);
+atomic<long> ast_arena::peak_heap_bytes(0);
+
+ast_arena::ast_arena()
+{
+    chunks = NULL;
+    next_free = NULL;
+    chunk_end = NULL;
+    bytes_used = 0;
+    bytes_held = 0;
+}
+
+
+ast_arena::~ast_arena()
+{
+    release();
+}
+
+
+/* Bump allocate size bytes. A new chunk is taken from the heap when the
+   current one can't hold the node; whatever is left of the old chunk is
+   wasted, which is fine since nodes are small. */
+void *ast_arena::allocate(size_t size)
+{
+    const size_t align = alignof(max_align_t);
+    size = (size + align - 1) & ~(align - 1);
+
+    if (next_free == NULL || (size_t) (chunk_end - next_free) < size) {
+        // Round the header up so the storage after it stays aligned.
+        size_t header = (sizeof(chunk) + align - 1) & ~(align - 1);
+        size_t chunk_size = (size_t) AST_ARENA_CHUNK;
+        if (chunks != NULL) {
+            chunk_size = (size_t) chunks->size * 2;
+            if (chunk_size > (size_t) AST_ARENA_MAX_CHUNK) {
+                chunk_size = (size_t) AST_ARENA_MAX_CHUNK;
+            }
+        }
+        if (size > chunk_size - header) {
+            chunk_size = size + header;
+        }
+
+        chunk *c = (chunk *) new char[chunk_size];
+        c->next = chunks;
+        c->size = chunk_size;
+        chunks = c;
+        next_free = (char *) c + header;
+        chunk_end = (char *) c + chunk_size;
+
+        bytes_held += chunk_size;
+        long held = heap_bytes += chunk_size;
+        long peak = peak_heap_bytes;
+        while (held > peak &&
+               !peak_heap_bytes.compare_exchange_weak(peak, held)) {
+        }
+    }
+
+    void *p = next_free;
+    next_free += size;
+    bytes_used += size;
+    total_objects++;
+    total_bytes += size;
+    live_bytes += size;
+    return p;
+}
+
+
+/* Free all chunks. The nodes in them are not destructed. */
+void ast_arena::release()
+{
+    while (chunks != NULL) {
+        chunk *next = chunks->next;
+        delete[] (char *) chunks;
+        chunks = next;
+    }
+    next_free = NULL;
+    chunk_end = NULL;
+
+    live_bytes -= bytes_used;
+    heap_bytes -= bytes_held;
+    bytes_used = 0;
+    bytes_held = 0;
+}
+
+
+/* Move the chunks of another arena behind ours. New nodes keep going in
+   our current chunk. */
+void ast_arena::adopt(ast_arena *other)
+{
+    if (other->chunks == NULL) {
+        return;
+    }
+    if (chunks == NULL) {
+        chunks = other->chunks;
+        next_free = other->next_free;
+        chunk_end = other->chunk_end;
+    } else {
+        chunk *last = other->chunks;
+        while (last->next != NULL) {
+            last = last->next;
+        }
+        last->next = chunks->next;
+        chunks->next = other->chunks;
+    }
+    bytes_used += other->bytes_used;
+    bytes_held += other->bytes_held;
+
+    other->chunks = NULL;
+    other->next_free = NULL;
+    other->chunk_end = NULL;
+    other->bytes_used = 0;
+    other->bytes_held = 0;
+}
+
+
+ast_arena *ast_arena::current()
+{
+    return current_arena != NULL ? current_arena : &default_arena;
+}
+
+
+void ast_arena::set_current(ast_arena *arena)
+{
+    current_arena = arena;
+}
+
+
+/* Print the node totals. Live bytes are the ones in arenas that have not
+   been released yet. */
+void ast_arena::print_statistics()
+{
+    cout << "AST nodes: " << total_objects << " objects, "
+         << total_bytes << " bytes allocated, " << live_bytes
+         << " bytes live" << endl;
+    cout << "AST arenas: " << heap_bytes << " bytes held, peak "
+         << peak_heap_bytes << " bytes" << endl;
+}
+
+
+
 /*******************************************************
  *** The abstract AST classes - never used directly. ***
  *******************************************************/
 
-int ast_node::indent_level = 0;
-bool ast_node::branches[10000];
+thread_local int ast_node::indent_level = 0;
+thread_local bool ast_node::branches[10000];
 
 /* The superclass ast_node. */
-ast_node::ast_node(position_information *p) :
+ast_node::ast_node(position_information p) :
     pos(p)
 {
     tag = AST_NODE;
@@ -17,7 +166,7 @@ ast_node::ast_node(position_information *p) :
 
 
 /* The ast_statement class. */
-ast_statement::ast_statement(position_information *p) :
+ast_statement::ast_statement(position_information p) :
     ast_node(p)
 {
     tag = AST_STATEMENT;
@@ -26,7 +175,7 @@ ast_statement::ast_statement(position_information *p) :
 
 
 /* The ast_expression class. */
-ast_expression::ast_expression(position_information *p) :
+ast_expression::ast_expression(position_information p) :
     ast_node(p)
 {
     tag = AST_EXPRESSION;
@@ -35,7 +184,7 @@ ast_expression::ast_expression(position_information *p) :
     type = void_type;
 }
 
-ast_expression::ast_expression(position_information *p,
+ast_expression::ast_expression(position_information p,
                                sym_index s) :
     ast_node(p),
     type(s)
@@ -45,7 +194,7 @@ ast_expression::ast_expression(position_information *p,
 
 
 /* The ast_binaryrelation class. They all return integer values. */
-ast_binaryrelation::ast_binaryrelation(position_information *p,
+ast_binaryrelation::ast_binaryrelation(position_information p,
                                        ast_expression *l,
                                        ast_expression *r) :
     ast_expression(p, integer_type),
@@ -58,7 +207,7 @@ ast_binaryrelation::ast_binaryrelation(position_information *p,
 
 /* The ast_binaryoperation class. The type of the node will be synthesized
    later, during type checking. See semantic.cc. */
-ast_binaryoperation::ast_binaryoperation(position_information *p,
+ast_binaryoperation::ast_binaryoperation(position_information p,
         ast_expression *l,
         ast_expression *r) :
     ast_expression(p),
@@ -70,13 +219,13 @@ ast_binaryoperation::ast_binaryoperation(position_information *p,
 
 
 /* The ast_lvalue class. */
-ast_lvalue::ast_lvalue(position_information *p) :
+ast_lvalue::ast_lvalue(position_information p) :
     ast_expression(p)
 {
     tag = AST_LVALUE;
 }
 
-ast_lvalue::ast_lvalue(position_information *p,
+ast_lvalue::ast_lvalue(position_information p,
                        sym_index s) :
     ast_expression(p, s)
 {
@@ -91,7 +240,7 @@ ast_lvalue::ast_lvalue(position_information *p,
  ***********************************************************/
 
 /* The ast_elsif class. */
-ast_elsif::ast_elsif(position_information *p,
+ast_elsif::ast_elsif(position_information p,
                      ast_expression *c,
                      ast_stmt_list *b) :
     ast_node(p),
@@ -103,70 +252,52 @@ ast_elsif::ast_elsif(position_information *p,
 
 
 /* The ast_expr_list class. Currently only used for parameter lists. */
-ast_expr_list::ast_expr_list(position_information *p,
+ast_expr_list::ast_expr_list(position_information p,
                              ast_expression *l) :
-    ast_node(p),
-    last_expr(l)
+    ast_node(p)
 {
     tag = AST_EXPR_LIST;
-    preceding = NULL;
+    exprs.add(l);
 }
 
-ast_expr_list::ast_expr_list(position_information *p,
-                             ast_expression *l,
-                             ast_expr_list *prev) :
-    ast_node(p),
-    last_expr(l),
-    preceding(prev)
+void ast_expr_list::add(ast_expression *l)
 {
-    tag = AST_EXPR_LIST;
+    exprs.add(l);
 }
 
 
 /* The ast_stmt_list class. */
-ast_stmt_list::ast_stmt_list(position_information *p,
+ast_stmt_list::ast_stmt_list(position_information p,
                              ast_statement *h) :
-    ast_node(p),
-    last_stmt(h)
+    ast_node(p)
 {
     tag = AST_STMT_LIST;
-    preceding = NULL;
+    stmts.add(h);
 }
 
-ast_stmt_list::ast_stmt_list(position_information *p,
-                             ast_statement *h,
-                             ast_stmt_list *t) :
-    ast_node(p),
-    last_stmt(h),
-    preceding(t)
+void ast_stmt_list::add(ast_statement *h)
 {
-    tag = AST_STMT_LIST;
+    stmts.add(h);
 }
 
 
 /* The ast_elsif_list class. */
-ast_elsif_list::ast_elsif_list(position_information *p,
+ast_elsif_list::ast_elsif_list(position_information p,
                                ast_elsif *h) :
-    ast_node(p),
-    last_elsif(h)
+    ast_node(p)
 {
     tag = AST_ELSIF_LIST;
-    preceding = NULL;
+    elsifs.add(h);
 }
 
-ast_elsif_list::ast_elsif_list(position_information *p,
-                               ast_elsif *h,
-                               ast_elsif_list *t) :
-    ast_node(p),
-    last_elsif(h),
-    preceding(t)
+void ast_elsif_list::add(ast_elsif *h)
 {
-    tag = AST_ELSIF_LIST;
+    elsifs.add(h);
 }
 
 
 /* The ast_procedurecall class. */
-ast_procedurecall::ast_procedurecall(position_information *p,
+ast_procedurecall::ast_procedurecall(position_information p,
                                      ast_id *i,
                                      ast_expr_list *par) :
     ast_statement(p),
@@ -178,7 +309,7 @@ ast_procedurecall::ast_procedurecall(position_information *p,
 
 
 /* The ast_assign class. */
-ast_assign::ast_assign(position_information *p,
+ast_assign::ast_assign(position_information p,
                        ast_lvalue *l,
                        ast_expression *r) :
     ast_statement(p),
@@ -190,7 +321,7 @@ ast_assign::ast_assign(position_information *p,
 
 
 /* The ast_while class. */
-ast_while::ast_while(position_information *p,
+ast_while::ast_while(position_information p,
                      ast_expression *c,
                      ast_stmt_list *b) :
     ast_statement(p),
@@ -202,7 +333,7 @@ ast_while::ast_while(position_information *p,
 
 
 /* The ast_if class. */
-ast_if::ast_if(position_information *p,
+ast_if::ast_if(position_information p,
                ast_expression *c,
                ast_stmt_list *b,
                ast_elsif_list *eil,
@@ -218,14 +349,14 @@ ast_if::ast_if(position_information *p,
 
 
 /* The ast_return class. */
-ast_return::ast_return(position_information *p) :
+ast_return::ast_return(position_information p) :
     ast_statement(p)
 {
     tag = AST_RETURN;
     value = NULL;
 }
 
-ast_return::ast_return(position_information *p,
+ast_return::ast_return(position_information p,
                        ast_expression *v) :
     ast_statement(p),
     value(v)
@@ -235,7 +366,7 @@ ast_return::ast_return(position_information *p,
 
 
 /* The ast_functioncall class. */
-ast_functioncall::ast_functioncall(position_information *p,
+ast_functioncall::ast_functioncall(position_information p,
                                    ast_id *i,
                                    ast_expr_list *par) :
     ast_expression(p, i->type),
@@ -250,7 +381,7 @@ ast_functioncall::ast_functioncall(position_information *p,
 /*** Unary operator nodes: ast_uminus, ast_not. */
 
 /* The ast_uminus class. */
-ast_uminus::ast_uminus(position_information *p,
+ast_uminus::ast_uminus(position_information p,
                        ast_expression *e) :
     ast_expression(p, e->type),
     expr(e)
@@ -259,7 +390,7 @@ ast_uminus::ast_uminus(position_information *p,
 }
 
 /* The ast_not class. Logical negation. */
-ast_not::ast_not(position_information *p,
+ast_not::ast_not(position_information p,
                  ast_expression *e) :
     ast_expression(p, integer_type),
     expr(e)
@@ -272,16 +403,16 @@ ast_not::ast_not(position_information *p,
 /*** Classes derived from ast_binaryrelation. ***/
 
 /* The ast_equal class. */
-ast_equal::ast_equal(position_information *p,
+ast_equal::ast_equal(position_information p,
                      ast_expression *l,
                      ast_expression *r) :
     ast_binaryrelation(p, l, r)
 {
-    tag = AST_BINARYRELATION;
+    tag = AST_EQUAL;
 }
 
 /* The ast_notequal class. */
-ast_notequal::ast_notequal(position_information *p,
+ast_notequal::ast_notequal(position_information p,
                            ast_expression *l,
                            ast_expression *r) :
     ast_binaryrelation(p, l, r)
@@ -291,7 +422,7 @@ ast_notequal::ast_notequal(position_information *p,
 
 
 /* The ast_lessthan class. */
-ast_lessthan::ast_lessthan(position_information *p,
+ast_lessthan::ast_lessthan(position_information p,
                            ast_expression *l,
                            ast_expression *r) :
     ast_binaryrelation(p, l, r)
@@ -300,7 +431,7 @@ ast_lessthan::ast_lessthan(position_information *p,
 }
 
 /* The ast_greaterthan class. */
-ast_greaterthan::ast_greaterthan(position_information *p,
+ast_greaterthan::ast_greaterthan(position_information p,
                                  ast_expression *l,
                                  ast_expression *r) :
     ast_binaryrelation(p, l, r)
@@ -313,7 +444,7 @@ ast_greaterthan::ast_greaterthan(position_information *p,
 /*** Classes derived from ast_binaryoperation. ***/
 
 /* The ast_add class. */
-ast_add::ast_add(position_information *p,
+ast_add::ast_add(position_information p,
                  ast_expression *l,
                  ast_expression *r) :
     ast_binaryoperation(p, l, r)
@@ -322,7 +453,7 @@ ast_add::ast_add(position_information *p,
 }
 
 /* The ast_sub class. */
-ast_sub::ast_sub(position_information *p,
+ast_sub::ast_sub(position_information p,
                  ast_expression *l,
                  ast_expression *r) :
     ast_binaryoperation(p, l, r)
@@ -331,7 +462,7 @@ ast_sub::ast_sub(position_information *p,
 }
 
 /* The ast_or class. */
-ast_or::ast_or(position_information *p,
+ast_or::ast_or(position_information p,
                ast_expression *l,
                ast_expression *r) :
     ast_binaryoperation(p, l, r)
@@ -340,7 +471,7 @@ ast_or::ast_or(position_information *p,
 }
 
 /* The ast_and class. */
-ast_and::ast_and(position_information *p,
+ast_and::ast_and(position_information p,
                  ast_expression *l,
                  ast_expression *r) :
     ast_binaryoperation(p, l, r)
@@ -349,7 +480,7 @@ ast_and::ast_and(position_information *p,
 }
 
 /* The ast_mult class. */
-ast_mult::ast_mult(position_information *p,
+ast_mult::ast_mult(position_information p,
                    ast_expression *l,
                    ast_expression *r) :
     ast_binaryoperation(p, l, r)
@@ -358,7 +489,7 @@ ast_mult::ast_mult(position_information *p,
 }
 
 /* The ast_divide class. */
-ast_divide::ast_divide(position_information *p,
+ast_divide::ast_divide(position_information p,
                        ast_expression *l,
                        ast_expression *r) :
     ast_binaryoperation(p, l, r)
@@ -367,7 +498,7 @@ ast_divide::ast_divide(position_information *p,
 }
 
 /* The ast_idiv class. */
-ast_idiv::ast_idiv(position_information *p,
+ast_idiv::ast_idiv(position_information p,
                    ast_expression *l,
                    ast_expression *r) :
     ast_binaryoperation(p, l, r)
@@ -376,7 +507,7 @@ ast_idiv::ast_idiv(position_information *p,
 }
 
 /* The ast_mod class. */
-ast_mod::ast_mod(position_information *p,
+ast_mod::ast_mod(position_information p,
                  ast_expression *l,
                  ast_expression *r) :
     ast_binaryoperation(p, l, r)
@@ -389,7 +520,7 @@ ast_mod::ast_mod(position_information *p,
 /*** Nodes that function as lvalues: ast_id and ast_indexed ***/
 
 /* The ast_id class. */
-ast_id::ast_id(position_information *p,
+ast_id::ast_id(position_information p,
                sym_index s) :
     ast_lvalue(p),
     sym_p(s)
@@ -399,7 +530,7 @@ ast_id::ast_id(position_information *p,
 
 
 /* The ast_indexed class. */
-ast_indexed::ast_indexed(position_information *p,
+ast_indexed::ast_indexed(position_information p,
                          ast_id *i,
                          ast_expression *n) :
     ast_lvalue(p),
@@ -413,7 +544,7 @@ ast_indexed::ast_indexed(position_information *p,
 /*** Nodes for representing integer/real constants, '5' or '2.5', or so. */
 
 /* The ast_integer class. */
-ast_integer::ast_integer(position_information *p,
+ast_integer::ast_integer(position_information p,
                          long i) :
     ast_expression(p, integer_type),
     value(i)
@@ -423,7 +554,7 @@ ast_integer::ast_integer(position_information *p,
 
 
 /* The ast_real class. Note: the value is stored in ieee 64-bit format. */
-ast_real::ast_real(position_information *p,
+ast_real::ast_real(position_information p,
                    double r) :
     ast_expression(p, real_type),
     value(r)
@@ -434,7 +565,7 @@ ast_real::ast_real(position_information *p,
 
 /* The ast_cast class. Used to convert integers to reals. Note: the value is
    stored in ieee 64-bit format. Cast nodes are always of real type. */
-ast_cast::ast_cast(position_information *p,
+ast_cast::ast_cast(position_information p,
                    ast_expression *n) :
     ast_expression(p, real_type),
     expr(n)
@@ -444,7 +575,7 @@ ast_cast::ast_cast(position_information *p,
 
 
 /* The ast_functionhead class. */
-ast_functionhead::ast_functionhead(position_information *p,
+ast_functionhead::ast_functionhead(position_information p,
                                    sym_index s) :
     ast_node(p),
     sym_p(s)
@@ -454,7 +585,7 @@ ast_functionhead::ast_functionhead(position_information *p,
 
 
 /* The ast_procedurehead class. */
-ast_procedurehead::ast_procedurehead(position_information *p,
+ast_procedurehead::ast_procedurehead(position_information p,
                                      sym_index s) :
     ast_node(p),
     sym_p(s)
@@ -595,43 +726,40 @@ void ast_elsif::print(ostream &o)
 }
 
 
+/* The lists used to be chains of nested list nodes, and are still printed
+   that way: each list node holds the list before its last element, and
+   that element. The elements are printed in a loop rather than by
+   recursion, so that a long list does not need as many stack frames. */
+template <class T>
+void ast_node::print_list(ostream &o, const char *header, ast_array<T> &list)
+{
+    for (int i = list.size() - 1; i >= 0; i--) {
+        o << header << "\n";
+        begin_child(o);
+    }
+    o << "NULL";
+    for (int i = 0; i < list.size(); i++) {
+        o << endl;
+        end_child(o);
+        last_child(o);
+        o << list[i];
+        end_child(o);
+    }
+}
+
 void ast_expr_list::print(ostream &o)
 {
-    o << "Expression list (preceding, last_expr)\n";
-    begin_child(o);
-    o << preceding << endl;
-    // o << last_expr << endl;
-    end_child(o);
-    last_child(o);
-    o << last_expr;
-    // o << preceding;
-    end_child(o);
+    print_list(o, "Expression list (preceding, last_expr)", exprs);
 }
 
 void ast_stmt_list::print(ostream &o)
 {
-    o << "Statement list (preceding, last_stmt)\n";
-    begin_child(o);
-    o << preceding << endl;
-    // o << last_stmt << endl;
-    end_child(o);
-    last_child(o);
-    // o << preceding;
-    o << last_stmt;
-    end_child(o);
+    print_list(o, "Statement list (preceding, last_stmt)", stmts);
 }
 
 void ast_elsif_list::print(ostream &o)
 {
-    o << "Elsif list (preceding, last_elsif)\n";
-    begin_child(o);
-    o << preceding << endl;
-    // o << last_elsif << endl;
-    end_child(o);
-    last_child(o);
-    // o << preceding;
-    o << last_elsif;
-    end_child(o);
+    print_list(o, "Elsif list (preceding, last_elsif)", elsifs);
 }
 
 
@@ -1,6 +1,7 @@
 #ifndef __AST_HH__
 #define __AST_HH__
 
+#include <atomic>
 #include "symtab.hh"
 #include "quads.hh"
 
@@ -131,7 +132,7 @@ enum ast_node_types {
 typedef enum ast_node_types ast_node_type;
 
 
-/* Needed so we can refer to quad_list& as arguments. See below. */
+/* Needed so we can refer to quad_list* as return values. See below. */
 class quad_list;
 
 
@@ -148,19 +149,144 @@ class quad_list;
 
 
 
+/*** The AST arena ***/
+
+/*!
+ Size of the first chunk an ast_arena takes from the heap. Each new chunk
+ is twice as large as the one before, up to AST_ARENA_MAX_CHUNK.
+ */
+const long AST_ARENA_CHUNK = 4 * 1024;
+const long AST_ARENA_MAX_CHUNK = 64 * 1024;
+
+/*!
+ Bump allocator for AST nodes. Every block of the program gets an arena
+ of its own, and all its nodes, including the ones made by the type
+ checker and the optimizer, are placed back to back in it. Nodes are
+ never freed one by one; once the block has been turned into quads, the
+ whole arena is released. Destructors of the nodes are never run; nodes
+ own no other memory.
+
+ New nodes go in the calling thread's current arena, see set_current().
+ */
+class ast_arena
+{
+private:
+    // Header of a chunk. The chunk's storage follows it directly.
+    struct chunk {
+        chunk *next;
+        long   size;
+    };
+
+    // Most recently allocated chunk, linked to the older ones.
+    chunk *chunks;
+
+    // Next free byte in the current chunk, and its end.
+    char *next_free;
+    char *chunk_end;
+
+    // Bytes handed out to nodes, and bytes taken from the heap.
+    long bytes_used;
+    long bytes_held;
+
+    // The arena new nodes go in, per thread. NULL means the default one.
+    static thread_local ast_arena *current_arena;
+
+    // Holds nodes made outside of any block. Never released.
+    static ast_arena default_arena;
+
+    // Totals over all arenas. Threads may update them at the same time.
+    static atomic<long> total_objects;
+    static atomic<long> total_bytes;
+    static atomic<long> live_bytes;
+    static atomic<long> heap_bytes;
+    static atomic<long> peak_heap_bytes;
+
+public:
+    ast_arena();
+
+    //! Releases the arena; see release().
+    ~ast_arena();
+
+    //! Returns suitably aligned storage for a node of the given size.
+    void *allocate(size_t);
+
+    /*! Frees all nodes in the arena at once. They must not be used
+      afterwards. The arena can be used again. */
+    void release();
+
+    //! Takes over all nodes of another arena, leaving it empty.
+    void adopt(ast_arena *);
+
+    //! Returns the calling thread's current arena.
+    static ast_arena *current();
+
+    //! Makes new nodes on the calling thread go in an arena, or in the default one if NULL.
+    static void set_current(ast_arena *);
+
+    //! Prints how many bytes of nodes have been allocated and how many are still live.
+    static void print_statistics();
+};
+
+
+/*!
+ A growable array of node pointers, for the list nodes. The elements are
+ kept in the current ast_arena along with the nodes, and are given back
+ with it; an array that has outgrown its storage just leaves the old
+ storage behind.
+ */
+template <class T> class ast_array
+{
+private:
+    T   **elements;
+    int   count;
+    int   capacity;
+
+public:
+    ast_array() : elements(NULL), count(0), capacity(0) {}
+
+    //! Returns the number of elements.
+    int size() const {
+        return count;
+    }
+
+    //! Returns the element at an index, from 0.
+    T *&operator[](int i) {
+        return elements[i];
+    }
+
+    //! Adds an element at the end.
+    void add(T *element) {
+        if (count == capacity) {
+            capacity = capacity == 0 ? 4 : 2 * capacity;
+            T **tmp = (T **) ast_arena::current()->allocate(capacity *
+                                                            sizeof(T *));
+            for (int i = 0; i < count; i++) {
+                tmp[i] = elements[i];
+            }
+            elements = tmp;
+        }
+        elements[count++] = element;
+    }
+};
+
+
+
 /*** Abstract classes ***/
 
 /*! The superclass of all other AST nodes. It is essentially an empty
  * class, holding only position information, a tag (to help identify the
  * node type when downcasting is needed), and methods for printing AST nodes;
- * all of which are things common to all nodes.
+ * all of which are things common to all nodes. Type checking, optimization
+ * and quad generation are passes over the nodes, which use the tag to find
+ * the method for each node; see visitor.hh.
  */
 class ast_node
 {
 protected:
-    // Used for AST printing.
-    static int indent_level;
-    static bool branches[10000];
+    // Used for AST printing. Kept per thread, since blocks may be printed
+    // on several threads at once.
+    static thread_local int indent_level;
+    static thread_local bool branches[10000];
 
     // All these methods are concerned with printing the AST.
     void indent(ostream &);
@@ -179,9 +305,13 @@ protected:
 
     virtual void xprint(ostream &, string);
 
+    // Prints the elements of a list node.
+    template <class T> void print_list(ostream &, const char *,
+                                       ast_array<T> &);
+
 public:
-    //! Holds line and column number for this node.
-    position_information *pos;
+    //! Holds the source location of this node.
+    position_information pos;
 
     /*! Describes what kind of node this is. We need to be able to check this
         in a convenient way during AST optimization and C++ does not support
@@ -190,24 +320,15 @@ public:
     ast_node_type tag;
 
     // Constructor.
-    ast_node(position_information *);
-
-    /*! Perform type checking. See semantic.cc for the method bodies.
-     * Note that it's an error to call type_check in this class. It should
-     * only be called in the concrete AST nodes, see below.
-     */
-    virtual sym_index type_check();
+    ast_node(position_information);
 
-    /*! Perform optimization. See optimize.cc for the method bodies.
-     * Just as with type checking, it's an error to call optimize in this
-     * class. It should only be called in the concrete AST nodes.
-     */
-    virtual void optimize();
+    //! Nodes are placed in the current ast_arena.
+    static void *operator new(size_t size) {
+        return ast_arena::current()->allocate(size);
+    }
 
-    /*! Generate quads. See quads.cc for the method bodies. Like type checking,
-     * generate_quads should only be called in concrete AST nodes.
-     */
-    virtual sym_index generate_quads(quad_list &) = 0;
+    //! Nodes are only freed along with their arena.
+    static void operator delete(void *) {}
 
     //! Allow an AST node to be sent to an outstream for printing.
     friend ostream &operator<<(ostream &, ast_node *);
@@ -222,14 +343,7 @@ protected:
     virtual void print(ostream &);
 public:
     // Constructor.
-    ast_statement(position_information *);
-
-    // It's an error if these methods are called. See the derived classes.
-    virtual sym_index type_check();
-
-    virtual void optimize();
-
-    virtual sym_index generate_quads(quad_list &) = 0;
+    ast_statement(position_information);
 };
 
 
@@ -247,46 +361,9 @@ public:
     sym_index type;
 
     // Constructors.
-    ast_expression(position_information *);
-
-    ast_expression(position_information *, sym_index);
-
-    // It's an error if these methods are called. See the derived classes.
-    virtual sym_index type_check();
-
-    virtual void optimize();
+    ast_expression(position_information);
 
-    virtual sym_index generate_quads(quad_list &) = 0;
-
-    // Used for safe downcasting. We could provide a mechanism to safely
-    // downcast ALL ast nodes... But these ones are the only ones we'll need
-    // in this lab course. They will be used during AST optimization.
-    // Note: It is not illegal to call these methods in other nodes than the
-    // ast_integer, ast_real - but those nodes are the only ones which will
-    // return non-NULL values.
-    virtual ast_integer *get_ast_integer() {
-        return NULL;
-    }
-
-    virtual ast_real *get_ast_real() {
-        return NULL;
-    }
-
-    virtual ast_id *get_ast_id() {
-        return NULL;
-    }
-
-    virtual ast_cast *get_ast_cast() {
-        return NULL;
-    }
-
-    // This, however, is very illegal. It's also only used in optimize.cc, to
-    // allow us to downcast an ast_expression to an ast_binaryoperation.
-    // See the comments in that file for more information.
-    virtual ast_binaryoperation *get_ast_binaryoperation() {
-        fatal("Illegal downcast to ast_binaryoperation from ast_expression");
-        return NULL;
-    }
+    ast_expression(position_information, sym_index);
 };
 
 
@@ -311,16 +388,9 @@ public:
     ast_expression *right;
 
     // Constructor.
-    ast_binaryrelation(position_information *,
+    ast_binaryrelation(position_information,
                        ast_expression *,
                        ast_expression *);
-
-    // It's an error if this method is called. See the derived classes.
-    virtual sym_index type_check();
-
-    virtual void optimize();
-
-    virtual sym_index generate_quads(quad_list &) = 0;
 };
 
 
@@ -341,22 +411,9 @@ public:
     ast_expression *right;
 
     // Constructor.
-    ast_binaryoperation(position_information *,
+    ast_binaryoperation(position_information,
                         ast_expression *,
                         ast_expression *);
-
-    // It's an error if these methods are called. See the derived classes.
-    virtual sym_index type_check();
-
-    virtual void optimize();
-
-    virtual sym_index generate_quads(quad_list &) = 0;
-
-    // Needed for safe downcasting.
-    virtual ast_binaryoperation *get_ast_binaryoperation() {
-        fatal("Illegal downcast to ast_binaryoperation");
-        return NULL;
-    }
 };
 
 
@@ -372,18 +429,9 @@ protected:
     virtual void print(ostream &);
 public:
     // Constructors.
-    ast_lvalue(position_information *);
+    ast_lvalue(position_information);
 
-    ast_lvalue(position_information *, sym_index);
-
-    // It's an error if this method is called. See the derived classes.
-    virtual sym_index type_check();
-
-    virtual void optimize();
-
-    virtual sym_index generate_quads(quad_list &) = 0;
-
-    virtual void generate_assignment(quad_list &, sym_index) = 0;
+    ast_lvalue(position_information, sym_index);
 };
 
 
@@ -409,18 +457,7 @@ public:
     ast_stmt_list *body;
 
     // Constructor.
-    ast_elsif(position_information *, ast_expression *, ast_stmt_list *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
-
-    virtual void generate_quads_and_jump(quad_list &, int);
+    ast_elsif(position_information, ast_expression *, ast_stmt_list *);
 };
 
 
@@ -434,30 +471,15 @@ class ast_expr_list : public ast_node
 protected:
     virtual void print(ostream &);
 public:
-    //! Points to the last (last added) expression in the list.
-    ast_expression *last_expr;
-
-    //! Points to a list of the preceding expressions. Is ``NULL`` when empty.
-    ast_expr_list *preceding;
+    /*! The expressions, in the order they were written. An expression
+      that could not be parsed is ``NULL``. */
+    ast_array<ast_expression> exprs;
 
     //! Constructor for the first element of a list.
-    ast_expr_list(position_information *, ast_expression *);
-
-    //! Constructor to add a new expression to the list.
-    ast_expr_list(position_information *, ast_expression *, ast_expr_list *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
+    ast_expr_list(position_information, ast_expression *);
 
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
-
-    virtual void generate_parameter_list(quad_list &,
-            parameter_symbol *,
-            int *);
+    //! Adds a new expression at the end of the list.
+    void add(ast_expression *);
 };
 
 
@@ -532,26 +554,14 @@ class ast_stmt_list : public ast_node
 protected:
     virtual void print(ostream &);
 public:
-    //! Points to the last (last added) statement in the list.
-    ast_statement *last_stmt;
-
-    //! Points to a list of the preceding statements. Is ``NULL`` when empty.
-    ast_stmt_list *preceding;
+    //! The statements, in the order they were written.
+    ast_array<ast_statement> stmts;
 
     //! Constructor for the first element of a list.
-    ast_stmt_list(position_information *, ast_statement *);
-
-    //! Constructor to add a new statement to the list.
-    ast_stmt_list(position_information *, ast_statement *, ast_stmt_list *);
+    ast_stmt_list(position_information, ast_statement *);
 
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
+    //! Adds a new statement at the end of the list.
+    void add(ast_statement *);
 };
 
 
@@ -562,28 +572,14 @@ class ast_elsif_list : public ast_node
 protected:
     virtual void print(ostream &);
 public:
-    //! Points to the last (last added) elsif clause in the list.
-    ast_elsif *last_elsif;
-
-    //! Points to a list of the preceding elsif clauses. Is ``NULL`` when empty.
-    ast_elsif_list *preceding;
+    //! The elsif clauses, in the order they were written.
+    ast_array<ast_elsif> elsifs;
 
     //! Constructor for the first element of a list.
-    ast_elsif_list(position_information *, ast_elsif *);
+    ast_elsif_list(position_information, ast_elsif *);
 
-    //! Constructor to add a new elsif clause to the list.
-    ast_elsif_list(position_information *, ast_elsif *, ast_elsif_list *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
-
-    virtual void generate_quads_and_jump(quad_list &, int);
+    //! Adds a new elsif clause at the end of the list.
+    void add(ast_elsif *);
 };
 
 
@@ -599,12 +595,7 @@ public:
     sym_index sym_p;
 
     // Constructor.
-    ast_functionhead(position_information *, sym_index);
-
-    // Only here since we're using abstract virtual methods in ast_node.
-    virtual void optimize();
-
-    virtual sym_index generate_quads(quad_list &);
+    ast_functionhead(position_information, sym_index);
 
     /*!
     Starts the generation of a quad list for a program block pointed to by the argument.
@@ -628,12 +619,7 @@ public:
     sym_index sym_p;
 
     // Constructor.
-    ast_procedurehead(position_information *, sym_index);
-
-    // Only here since we're using abstract virtual methods in ast_node.
-    virtual void optimize();
-
-    virtual sym_index generate_quads(quad_list &);
+    ast_procedurehead(position_information, sym_index);
 
     /*!
     Starts the generation of a quad list for a program block pointed to by the argument.
@@ -720,16 +706,7 @@ public:
     ast_expr_list *parameter_list;
 
     // Constructor.
-    ast_procedurecall(position_information *, ast_id *, ast_expr_list *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
+    ast_procedurecall(position_information, ast_id *, ast_expr_list *);
 };
 
 
@@ -752,16 +729,7 @@ public:
     ast_expression *rhs;
 
     // Constructor.
-    ast_assign(position_information *, ast_lvalue *, ast_expression *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
+    ast_assign(position_information, ast_lvalue *, ast_expression *);
 };
 
 
@@ -782,16 +750,7 @@ public:
     ast_stmt_list *body;
 
     // Constructor.
-    ast_while(position_information *, ast_expression *, ast_stmt_list *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
+    ast_while(position_information, ast_expression *, ast_stmt_list *);
 };
 
 
@@ -921,20 +880,11 @@ public:
     ast_stmt_list *else_body;
 
     // Constructor.
-    ast_if(position_information *,
+    ast_if(position_information,
            ast_expression *,
            ast_stmt_list *,
            ast_elsif_list *,
            ast_stmt_list *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
 };
 
 
@@ -956,19 +906,10 @@ public:
     ast_expression *value;
 
     //! Constructor for no return value.
-    ast_return(position_information *);
+    ast_return(position_information);
 
     //! Constructor with a return value.
-    ast_return(position_information *, ast_expression *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
+    ast_return(position_information, ast_expression *);
 };
 
 
@@ -997,16 +938,7 @@ public:
     ast_expr_list *parameter_list;
 
     // Constructor.
-    ast_functioncall(position_information *, ast_id *, ast_expr_list *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
+    ast_functioncall(position_information, ast_id *, ast_expr_list *);
 };
 
 
@@ -1024,16 +956,7 @@ public:
     ast_expression *expr;
 
     // Constructor.
-    ast_uminus(position_information *, ast_expression *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
+    ast_uminus(position_information, ast_expression *);
 };
 
 
@@ -1047,16 +970,7 @@ public:
     ast_expression *expr;
 
     // Constructor.
-    ast_not(position_information *, ast_expression *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
+    ast_not(position_information, ast_expression *);
 };
 
 
@@ -1070,21 +984,7 @@ public:
     long value;
 
     // Constructor.
-    ast_integer(position_information *, long);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
-
-    // Safe downcasting.
-    virtual ast_integer *get_ast_integer() {
-        return this;
-    }
+    ast_integer(position_information, long);
 };
 
 
@@ -1098,21 +998,7 @@ public:
     double value;
 
     // Constructor.
-    ast_real(position_information *, double);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
-
-    // Safe downcasting.
-    virtual ast_real *get_ast_real() {
-        return this;
-    }
+    ast_real(position_information, double);
 };
 
 
@@ -1131,18 +1017,7 @@ public:
     ast_expression *expr;
 
     // Constructor.
-    ast_cast(position_information *, ast_expression *);
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
-
-    // Safe downcasting.
-    virtual ast_cast *get_ast_cast() {
-        return this;
-    }
+    ast_cast(position_information, ast_expression *);
 };
 
 
@@ -1156,16 +1031,7 @@ protected:
     virtual void print(ostream &);
 public:
     // Constructor.
-    ast_equal(position_information *, ast_expression *, ast_expression *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
+    ast_equal(position_information, ast_expression *, ast_expression *);
 };
 
 
@@ -1176,16 +1042,7 @@ protected:
     virtual void print(ostream &);
 public:
     // Constructor.
-    ast_notequal(position_information *, ast_expression *, ast_expression *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
+    ast_notequal(position_information, ast_expression *, ast_expression *);
 };
 
 
@@ -1196,16 +1053,7 @@ protected:
     virtual void print(ostream &);
 public:
     // Constructor.
-    ast_lessthan(position_information *, ast_expression *, ast_expression *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
+    ast_lessthan(position_information, ast_expression *, ast_expression *);
 };
 
 
@@ -1216,16 +1064,7 @@ protected:
     virtual void print(ostream &);
 public:
     // Constructor.
-    ast_greaterthan(position_information *, ast_expression *, ast_expression *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
+    ast_greaterthan(position_information, ast_expression *, ast_expression *);
 };
 
 
@@ -1263,21 +1102,7 @@ protected:
     virtual void print(ostream &);
 public:
     // Constructor.
-    ast_add(position_information *, ast_expression *, ast_expression *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
-
-    // Safe downcasts.
-    virtual ast_add *get_ast_binaryoperation() {
-        return this;
-    }
+    ast_add(position_information, ast_expression *, ast_expression *);
 };
 
 
@@ -1288,21 +1113,7 @@ protected:
     virtual void print(ostream &);
 public:
     // Constructor.
-    ast_sub(position_information *, ast_expression *, ast_expression *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
-
-    // Safe downcasts.
-    virtual ast_sub *get_ast_binaryoperation() {
-        return this;
-    }
+    ast_sub(position_information, ast_expression *, ast_expression *);
 };
 
 
@@ -1313,21 +1124,7 @@ protected:
     virtual void print(ostream &);
 public:
     // Constructor.
-    ast_or(position_information *, ast_expression *, ast_expression *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
-
-    // Safe downcasts.
-    virtual ast_or *get_ast_binaryoperation() {
-        return this;
-    }
+    ast_or(position_information, ast_expression *, ast_expression *);
 };
 
 
@@ -1338,21 +1135,7 @@ protected:
     virtual void print(ostream &);
 public:
     // Constructor.
-    ast_and(position_information *, ast_expression *, ast_expression *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
-
-    // Safe downcasts.
-    virtual ast_and *get_ast_binaryoperation() {
-        return this;
-    }
+    ast_and(position_information, ast_expression *, ast_expression *);
 };
 
 
@@ -1363,21 +1146,7 @@ protected:
     virtual void print(ostream &);
 public:
     // Constructor.
-    ast_mult(position_information *, ast_expression *, ast_expression *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
-
-    // Safe downcasts.
-    virtual ast_mult *get_ast_binaryoperation() {
-        return this;
-    }
+    ast_mult(position_information, ast_expression *, ast_expression *);
 };
 
 
@@ -1388,21 +1157,7 @@ protected:
     virtual void print(ostream &);
 public:
     // Constructor.
-    ast_divide(position_information *, ast_expression *, ast_expression *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
-
-    // Safe downcasts.
-    virtual ast_divide *get_ast_binaryoperation() {
-        return this;
-    }
+    ast_divide(position_information, ast_expression *, ast_expression *);
 };
 
 
@@ -1413,21 +1168,7 @@ protected:
     virtual void print(ostream &);
 public:
     // Constructor.
-    ast_idiv(position_information *, ast_expression *, ast_expression *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
-
-    // Safe downcasts.
-    virtual ast_idiv *get_ast_binaryoperation() {
-        return this;
-    }
+    ast_idiv(position_information, ast_expression *, ast_expression *);
 };
 
 
@@ -1438,21 +1179,7 @@ protected:
     virtual void print(ostream &);
 public:
     // Constructor.
-    ast_mod(position_information *, ast_expression *, ast_expression *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
-
-    // Safe downcasts.
-    virtual ast_mod *get_ast_binaryoperation() {
-        return this;
-    }
+    ast_mod(position_information, ast_expression *, ast_expression *);
 };
 
 
@@ -1468,25 +1195,9 @@ public:
     sym_index sym_p;
 
     // Constructors.
-    ast_id(position_information *);
-
-    ast_id(position_information *, sym_index);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
+    ast_id(position_information);
 
-    virtual void generate_assignment(quad_list &, sym_index);
-
-    // Safe downcasting.
-    virtual ast_id *get_ast_id() {
-        return this;
-    }
+    ast_id(position_information, sym_index);
 };
 
 
@@ -1538,18 +1249,7 @@ public:
     ast_expression *index;
 
     // Constructor.
-    ast_indexed(position_information *, ast_id *, ast_expression *);
-
-    // Perform type checking.
-    virtual sym_index type_check();
-
-    // AST optimization.
-    virtual void optimize();
-
-    // Quad generation.
-    virtual sym_index generate_quads(quad_list &);
-
-    virtual void generate_assignment(quad_list &, sym_index);
+    ast_indexed(position_information, ast_id *, ast_expression *);
 };
 
 
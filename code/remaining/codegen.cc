@@ -19,8 +19,9 @@ code_generator *code_gen = new code_generator("d.out");
 
 // Constructor.
 code_generator::code_generator(const string object_file_name)
+    : out(&file)
 {
-    out.open(object_file_name);
+    file.open(object_file_name, ios::out);
 
     reg[RAX] = "rax";
     reg[RCX] = "rcx";
@@ -28,12 +29,22 @@ code_generator::code_generator(const string object_file_name)
 }
 
 
+// Constructor for generating code into a buffer.
+code_generator::code_generator(label_buffer *buffer)
+    : out(buffer)
+{
+    reg[RAX] = "rax";
+    reg[RCX] = "rcx";
+    reg[RDX] = "rdx";
+}
+
+
 /* Destructor. */
 code_generator::~code_generator()
 {
     // Make sure we close the outfile before exiting the compiler.
     out << flush;
-    out.close();
+    file.close();
 }
 
 
@@ -50,6 +61,17 @@ void code_generator::generate_assembler(quad_list *q, symbol *env)
 
 
 
+/* Write code generated elsewhere into a buffer to the output, where it
+   ends up after what has been generated so far. The compiler exits
+   without destroying code_gen, so flush it. */
+void code_generator::append_code(label_buffer &buffer, long shift)
+{
+    buffer.write_to(out, shift);
+    out << flush;
+}
+
+
+
 /* This method aligns a frame size on an 8-byte boundary. Used by prologue().
  */
 int code_generator::align(int frame_size)
@@ -136,25 +158,25 @@ void code_generator::epilogue(symbol *old_env)
 void code_generator::find(sym_index sym_p, int *level, int *offset)
 {
     /* Your code here */
-    auto symbol = sym_tab->get_symbol(sym_p);
-    *level = symbol->level;
-    if (symbol->tag == SYM_PARAM)
+    // Read straight from the symbol table's hot field tables.
+    *level = sym_tab->get_symbol_level(sym_p);
+    if (sym_tab->get_symbol_tag(sym_p) == SYM_PARAM)
     {
         // Located above RBP in the stack (=> plus)
         // Jump over return address
         *offset = STACK_WIDTH;
         // Jump to symbol
-        *offset += symbol->offset;
+        *offset += sym_tab->get_symbol_offset(sym_p);
         // Jump to the beginning of the symbol
-        *offset += symbol->get_parameter_symbol()->size;
+        *offset += sym_tab->get_param_size(sym_p);
     }
     else 
     {
         // Located below RBP in the stack (=> minus)
         // Jump over the display area
-        *offset = -(symbol->level + 1) * STACK_WIDTH;
+        *offset = -(*level + 1) * STACK_WIDTH;
         // Jump to the symbol
-        *offset -= symbol->offset;   
+        *offset -= sym_tab->get_symbol_offset(sym_p);
     }
     // *offset = symbol->offset;
 }
@@ -173,11 +195,9 @@ void code_generator::frame_address(int level, const register_type dest)
 void code_generator::fetch(sym_index sym_p, register_type dest)
 {
     /* Your code here */
-        auto symbol = sym_tab->get_symbol(sym_p);
-    if (symbol->tag == SYM_CONST)
+    if (sym_tab->get_symbol_tag(sym_p) == SYM_CONST)
     {
-        constant_symbol* const_sym = symbol->get_constant_symbol();
-        out << "\t\t" << "mov" << "\t" << reg[dest] << ", " << const_sym->const_value.ival << endl;
+        out << "\t\t" << "mov" << "\t" << reg[dest] << ", " << sym_tab->get_const_value(sym_p).ival << endl;
         return;
     }
     block_level level;      // Current scope level.
@@ -197,11 +217,9 @@ void code_generator::fetch(sym_index sym_p, register_type dest)
 void code_generator::fetch_float(sym_index sym_p)
 {
     /* Your code here */
-    auto symbol = sym_tab->get_symbol(sym_p);
-    if (symbol->tag == SYM_CONST)
+    if (sym_tab->get_symbol_tag(sym_p) == SYM_CONST)
     {
-        constant_symbol* const_sym = symbol->get_constant_symbol();
-        out << "\t\t" << "mov" << "\t" << "rcx, " << sym_tab->ieee(const_sym->const_value.rval) << endl;
+        out << "\t\t" << "mov" << "\t" << "rcx, " << sym_tab->ieee(sym_tab->get_const_value(sym_p).rval) << endl;
         out << "\t\t" << "push" << "\t" << "rcx" << endl;
         out << "\t\t" << "fld" << "\t" << "qword ptr [rsp]" << endl;
         out << "\t\t" << "add" << "\t" << "rsp, " << STACK_WIDTH << endl;
@@ -293,7 +311,7 @@ void code_generator::expand(quad_list *q_list)
         // We always do labels here so that a branch doesn't miss the
         // trace code.
         if (q->op_code == q_labl) {
-            out << "L" << q->int1 << ":" << endl;
+            out << "L" << label_ref(q->int1) << ":" << endl;
         }
 
         // Debug output.
@@ -317,15 +335,15 @@ void code_generator::expand(quad_list *q_list)
 
             fetch(q->sym1, RAX);
             out << "\t\t" << "cmp" << "\t" << "rax, 0" << endl;
-            out << "\t\t" << "je" << "\t" << "L" << label << endl;
+            out << "\t\t" << "je" << "\t" << "L" << label_ref(label) << endl;
             // Not equal branch
             out << "\t\t" << "mov" << "\t" << "rax, 0" << endl;
-            out << "\t\t" << "jmp" << "\t" << "L" << label2 << endl;
+            out << "\t\t" << "jmp" << "\t" << "L" << label_ref(label2) << endl;
             // Equal branch
-            out << "\t\t" << "L" << label << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label) << ":" << endl;
             out << "\t\t" << "mov" << "\t" << "rax, 1" << endl;
 
-            out << "\t\t" << "L" << label2 << ":" <<  endl;
+            out << "\t\t" << "L" << label_ref(label2) << ":" <<  endl;
             store(RAX, q->sym3);
             break;
         }
@@ -375,18 +393,18 @@ void code_generator::expand(quad_list *q_list)
 
             fetch(q->sym1, RAX);
             out << "\t\t" << "cmp" << "\t" << "rax, 0" << endl;
-            out << "\t\t" << "jne" << "\t" << "L" << label << endl;
+            out << "\t\t" << "jne" << "\t" << "L" << label_ref(label) << endl;
             fetch(q->sym2, RAX);
             out << "\t\t" << "cmp" << "\t" << "rax, 0" << endl;
-            out << "\t\t" << "jne" << "\t" << "L" << label << endl;
+            out << "\t\t" << "jne" << "\t" << "L" << label_ref(label) << endl;
             // False branch
             out << "\t\t" << "mov" << "\t" << "rax, 0" << endl;
-            out << "\t\t" << "jmp" << "\t" << "L" << label2 << endl;
+            out << "\t\t" << "jmp" << "\t" << "L" << label_ref(label2) << endl;
             // True branch
-            out << "\t\t" << "L" << label << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label) << ":" << endl;
             out << "\t\t" << "mov" << "\t" << "rax, 1" << endl;
 
-            out << "\t\t" << "L" << label2 << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label2) << ":" << endl;
             store(RAX, q->sym3);
             break;
         }
@@ -396,18 +414,18 @@ void code_generator::expand(quad_list *q_list)
 
             fetch(q->sym1, RAX);
             out << "\t\t" << "cmp" << "\t" << "rax, 0" << endl;
-            out << "\t\t" << "je" << "\t" << "L" << label << endl;
+            out << "\t\t" << "je" << "\t" << "L" << label_ref(label) << endl;
             fetch(q->sym2, RAX);
             out << "\t\t" << "cmp" << "\t" << "rax, 0" << endl;
-            out << "\t\t" << "je" << "\t" << "L" << label << endl;
+            out << "\t\t" << "je" << "\t" << "L" << label_ref(label) << endl;
             // True branch
             out << "\t\t" << "mov" << "\t" << "rax, 1" << endl;
-            out << "\t\t" << "jmp" << "\t" << "L" << label2 << endl;
+            out << "\t\t" << "jmp" << "\t" << "L" << label_ref(label2) << endl;
             // False branch
-            out << "\t\t" << "L" << label << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label) << ":" << endl;
             out << "\t\t" << "mov" << "\t" << "rax, 0" << endl;
 
-            out << "\t\t" << "L" << label2 << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label2) << ":" << endl;
             store(RAX, q->sym3);
             break;
         }
@@ -457,15 +475,15 @@ void code_generator::expand(quad_list *q_list)
             out << "\t\t" << "fcomip" << "\t" << "ST(0), ST(1)" << endl;
             // Clear the stack
             out << "\t\t" << "fstp" << "\t" << "ST(0)" << endl;
-            out << "\t\t" << "je" << "\t" << "L" << label << endl;
+            out << "\t\t" << "je" << "\t" << "L" << label_ref(label) << endl;
             // False branch
             out << "\t\t" << "mov" << "\t" << "rax, 0" << endl;
-            out << "\t\t" << "jmp" << "\t" << "L" << label2 << endl;
+            out << "\t\t" << "jmp" << "\t" << "L" << label_ref(label2) << endl;
             // True branch
-            out << "\t\t" << "L" << label << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label) << ":" << endl;
             out << "\t\t" << "mov" << "\t" << "rax, 1" << endl;
 
-            out << "\t\t" << "L" << label2 << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label2) << ":" << endl;
             store(RAX, q->sym3);
             break;
         }
@@ -476,15 +494,15 @@ void code_generator::expand(quad_list *q_list)
             fetch(q->sym1, RAX);
             fetch(q->sym2, RCX);
             out << "\t\t" << "cmp" << "\t" << "rax, rcx" << endl;
-            out << "\t\t" << "je" << "\t" << "L" << label << endl;
+            out << "\t\t" << "je" << "\t" << "L" << label_ref(label) << endl;
             // False branch
             out << "\t\t" << "mov" << "\t" << "rax, 0" << endl;
-            out << "\t\t" << "jmp" << "\t" << "L" << label2 << endl;
+            out << "\t\t" << "jmp" << "\t" << "L" << label_ref(label2) << endl;
             // True branch
-            out << "\t\t" << "L" << label << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label) << ":" << endl;
             out << "\t\t" << "mov" << "\t" << "rax, 1" << endl;
 
-            out << "\t\t" << "L" << label2 << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label2) << ":" << endl;
             store(RAX, q->sym3);
             break;
         }
@@ -497,15 +515,15 @@ void code_generator::expand(quad_list *q_list)
             out << "\t\t" << "fcomip" << "\t" << "ST(0), ST(1)" << endl;
             // Clear the stack
             out << "\t\t" << "fstp" << "\t" << "ST(0)" << endl;
-            out << "\t\t" << "jne" << "\t" << "L" << label << endl;
+            out << "\t\t" << "jne" << "\t" << "L" << label_ref(label) << endl;
             // False branch
             out << "\t\t" << "mov" << "\t" << "rax, 0" << endl;
-            out << "\t\t" << "jmp" << "\t" << "L" << label2 << endl;
+            out << "\t\t" << "jmp" << "\t" << "L" << label_ref(label2) << endl;
             // True branch
-            out << "\t\t" << "L" << label << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label) << ":" << endl;
             out << "\t\t" << "mov" << "\t" << "rax, 1" << endl;
 
-            out << "\t\t" << "L" << label2 << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label2) << ":" << endl;
             store(RAX, q->sym3);
             break;
         }
@@ -516,15 +534,15 @@ void code_generator::expand(quad_list *q_list)
             fetch(q->sym1, RAX);
             fetch(q->sym2, RCX);
             out << "\t\t" << "cmp" << "\t" << "rax, rcx" << endl;
-            out << "\t\t" << "jne" << "\t" << "L" << label << endl;
+            out << "\t\t" << "jne" << "\t" << "L" << label_ref(label) << endl;
             // False branch
             out << "\t\t" << "mov" << "\t" << "rax, 0" << endl;
-            out << "\t\t" << "jmp" << "\t" << "L" << label2 << endl;
+            out << "\t\t" << "jmp" << "\t" << "L" << label_ref(label2) << endl;
             // True branch
-            out << "\t\t" << "L" << label << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label) << ":" << endl;
             out << "\t\t" << "mov" << "\t" << "rax, 1" << endl;
 
-            out << "\t\t" << "L" << label2 << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label2) << ":" << endl;
             store(RAX, q->sym3);
             break;
         }
@@ -538,15 +556,15 @@ void code_generator::expand(quad_list *q_list)
             out << "\t\t" << "fcomip" << "\t" << "ST(0), ST(1)" << endl;
             // Clear the stack
             out << "\t\t" << "fstp" << "\t" << "ST(0)" << endl;
-            out << "\t\t" << "jb" << "\t" << "L" << label << endl;
+            out << "\t\t" << "jb" << "\t" << "L" << label_ref(label) << endl;
             // False branch
             out << "\t\t" << "mov" << "\t" << "rax, 0" << endl;
-            out << "\t\t" << "jmp" << "\t" << "L" << label2 << endl;
+            out << "\t\t" << "jmp" << "\t" << "L" << label_ref(label2) << endl;
             // True branch
-            out << "\t\t" << "L" << label << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label) << ":" << endl;
             out << "\t\t" << "mov" << "\t" << "rax, 1" << endl;
 
-            out << "\t\t" << "L" << label2 << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label2) << ":" << endl;
             store(RAX, q->sym3);
             break;
         }
@@ -557,15 +575,15 @@ void code_generator::expand(quad_list *q_list)
             fetch(q->sym1, RAX);
             fetch(q->sym2, RCX);
             out << "\t\t" << "cmp" << "\t" << "rax, rcx" << endl;
-            out << "\t\t" << "jl" << "\t" << "L" << label << endl;
+            out << "\t\t" << "jl" << "\t" << "L" << label_ref(label) << endl;
             // False branch
             out << "\t\t" << "mov" << "\t" << "rax, 0" << endl;
-            out << "\t\t" << "jmp" << "\t" << "L" << label2 << endl;
+            out << "\t\t" << "jmp" << "\t" << "L" << label_ref(label2) << endl;
             // True branch
-            out << "\t\t" << "L" << label << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label) << ":" << endl;
             out << "\t\t" << "mov" << "\t" << "rax, 1" << endl;
 
-            out << "\t\t" << "L" << label2 << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label2) << ":" << endl;
             store(RAX, q->sym3);
             break;
         }
@@ -579,15 +597,15 @@ void code_generator::expand(quad_list *q_list)
             out << "\t\t" << "fcomip" << "\t" << "ST(0), ST(1)" << endl;
             // Clear the stack
             out << "\t\t" << "fstp" << "\t" << "ST(0)" << endl;
-            out << "\t\t" << "ja" << "\t" << "L" << label << endl;
+            out << "\t\t" << "ja" << "\t" << "L" << label_ref(label) << endl;
             // False branch
             out << "\t\t" << "mov" << "\t" << "rax, 0" << endl;
-            out << "\t\t" << "jmp" << "\t" << "L" << label2 << endl;
+            out << "\t\t" << "jmp" << "\t" << "L" << label_ref(label2) << endl;
             // True branch
-            out << "\t\t" << "L" << label << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label) << ":" << endl;
             out << "\t\t" << "mov" << "\t" << "rax, 1" << endl;
 
-            out << "\t\t" << "L" << label2 << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label2) << ":" << endl;
             store(RAX, q->sym3);
             break;
         }
@@ -598,15 +616,15 @@ void code_generator::expand(quad_list *q_list)
             fetch(q->sym1, RAX);
             fetch(q->sym2, RCX);
             out << "\t\t" << "cmp" << "\t" << "rax, rcx" << endl;
-            out << "\t\t" << "jg" << "\t" << "L" << label << endl;
+            out << "\t\t" << "jg" << "\t" << "L" << label_ref(label) << endl;
             // False branch
             out << "\t\t" << "mov" << "\t" << "rax, 0" << endl;
-            out << "\t\t" << "jmp" << "\t" << "L" << label2 << endl;
+            out << "\t\t" << "jmp" << "\t" << "L" << label_ref(label2) << endl;
             // True branch
-            out << "\t\t" << "L" << label << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label) << ":" << endl;
             out << "\t\t" << "mov" << "\t" << "rax, 1" << endl;
 
-            out << "\t\t" << "L" << label2 << ":" << endl;
+            out << "\t\t" << "L" << label_ref(label2) << ":" << endl;
             store(RAX, q->sym3);
             break;
         }
@@ -631,18 +649,16 @@ void code_generator::expand(quad_list *q_list)
 
         case q_call: {
             /* Your code here */
-            auto symbol = sym_tab->get_symbol(q->sym1);
-            if (symbol->tag == SYM_FUNC)
+            sym_type tag = sym_tab->get_symbol_tag(q->sym1);
+            if (tag == SYM_FUNC)
             {
-                function_symbol* fun_sym = symbol->get_function_symbol();
-                out << "\t\t" << "call" << "\t" << "L" << fun_sym->label_nr << "\t" << "# " << sym_tab->pool_lookup(symbol->id) << endl;
+                out << "\t\t" << "call" << "\t" << "L" << sym_tab->get_label_nr(q->sym1) << "\t" << "# " << sym_tab->pool_lookup(sym_tab->get_symbol_id(q->sym1)) << endl;
                 out << "\t\t" << "add" << "\t" << "rsp, " << q->int2 * STACK_WIDTH << endl;
                 store(RAX, q->sym3);
             }
-            else if (symbol->tag == SYM_PROC)
+            else if (tag == SYM_PROC)
             {
-                procedure_symbol* proc_sym = symbol->get_procedure_symbol();
-                out << "\t\t" << "call" << "\t" << "L" << proc_sym->label_nr << "\t" << "# " << sym_tab->pool_lookup(symbol->id) << endl;
+                out << "\t\t" << "call" << "\t" << "L" << sym_tab->get_label_nr(q->sym1) << "\t" << "# " << sym_tab->pool_lookup(sym_tab->get_symbol_id(q->sym1)) << endl;
                 out << "\t\t" << "add" << "\t" << "rsp, " << q->int2 * STACK_WIDTH << endl;
             }
             break;
@@ -650,7 +666,7 @@ void code_generator::expand(quad_list *q_list)
         case q_rreturn:
         case q_ireturn:
             fetch(q->sym2, RAX);
-            out << "\t\t" << "jmp" << "\t" << "L" << q->int1 << endl;
+            out << "\t\t" << "jmp" << "\t" << "L" << label_ref(q->int1) << endl;
             break;
 
         case q_lindex:
@@ -689,13 +705,13 @@ void code_generator::expand(quad_list *q_list)
         break;
 
         case q_jmp:
-            out << "\t\t" << "jmp" << "\t" << "L" << q->int1 << endl;
+            out << "\t\t" << "jmp" << "\t" << "L" << label_ref(q->int1) << endl;
             break;
 
         case q_jmpf:
             fetch(q->sym2, RAX);
             out << "\t\t" << "cmp" << "\t" << "rax, 0" << endl;
-            out << "\t\t" << "je" << "\t" << "L" << q->int1 << endl;
+            out << "\t\t" << "je" << "\t" << "L" << label_ref(q->int1) << endl;
             break;
 
         case q_labl:
@@ -26,8 +26,9 @@ private:
     // Register array.
     string reg[3];
 
-    // Output file stream.
-    ofstream out;
+    // Where the code goes: the output file, or a buffer.
+    filebuf file;
+    ostream out;
 
     //! Aligns a stack frame on an 8-byte boundary.
     int  align(int);
@@ -92,6 +93,10 @@ public:
     // Constructor. Arg = filename of assembler outfile.
     code_generator(const string);
 
+    // Constructor for a generator that writes its code to a buffer, for
+    // generating code on a worker thread. See append_code().
+    code_generator(label_buffer *);
+
     // Destructor.
     ~code_generator();
 
@@ -100,6 +105,9 @@ public:
       expansion of a code block represented as a quad list.
      */
     void generate_assembler(quad_list *, symbol *env);
+
+    //! Writes code generated into a buffer to the output, with shift added to its labels.
+    void append_code(label_buffer &, long shift);
 };
 
 #endif
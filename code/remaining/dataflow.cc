@@ -0,0 +1,300 @@
+#include <iomanip>
+#include "dataflow.hh"
+
+
+dataflow_analysis::dataflow_analysis(flow_graph &g) :
+    graph(g)
+{
+}
+
+
+void dataflow_analysis::init_sets(int nr_facts)
+{
+    gen.assign(graph.blocks.size(), fact_set(nr_facts, false));
+    kill.assign(graph.blocks.size(), fact_set(nr_facts, false));
+}
+
+
+/* Blocks are gone over in the direction of the analysis, so that in a
+   graph without loops one round is enough, and another round confirms
+   it. When facts must hold on all paths, every set starts out full, and
+   only loses the facts some path does not have. */
+void dataflow_analysis::solve(bool forward, bool any_path,
+                              const fact_set &boundary)
+{
+    int nr_blocks = graph.blocks.size();
+    int nr_facts = boundary.size();
+
+    in.assign(nr_blocks, fact_set(nr_facts, !any_path));
+    out.assign(nr_blocks, fact_set(nr_facts, !any_path));
+
+    fact_set met(nr_facts);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = 0; i < nr_blocks; i++) {
+            int b = forward ? i : nr_blocks - 1 - i;
+            basic_block &block = graph.blocks[b];
+            vector<int> &neighbours = forward ? block.pred : block.succ;
+            vector<fact_set> &from = forward ? out : in;
+
+            if ((forward && b == 0) || (!forward && block.succ.empty())) {
+                met = boundary;
+            } else {
+                met.assign(nr_facts, !any_path);
+            }
+            for (size_t n = 0; n < neighbours.size(); n++) {
+                fact_set &other = from[neighbours[n]];
+                for (int k = 0; k < nr_facts; k++) {
+                    met[k] = any_path ? met[k] || other[k] : met[k] && other[k];
+                }
+            }
+
+            fact_set &after = forward ? out[b] : in[b];
+            for (int k = 0; k < nr_facts; k++) {
+                bool fact = gen[b][k] || (met[k] && !kill[b][k]);
+                if (after[k] != fact) {
+                    after[k] = fact;
+                    changed = true;
+                }
+            }
+            (forward ? in[b] : out[b]) = met;
+        }
+    }
+}
+
+
+
+/*** Liveness. ***/
+
+/* True if a call to a procedure may read or assign a variable: it can see
+   the variables declared on its own level and outside it. */
+static bool seen_by_call(quadruple *q, sym_index sym_p)
+{
+    return !sym_tab->is_temp(sym_p) &&
+        sym_tab->get_symbol_level(sym_p) <= sym_tab->get_symbol_level(q->sym1);
+}
+
+
+/* A variable read in a block before it is assigned there is live at its
+   start, and one assigned in it is not, unless it is read first. */
+liveness::liveness(flow_graph &g, block_level outer_level) :
+    dataflow_analysis(g)
+{
+    int nr_variables = graph.variables.size();
+    init_sets(nr_variables);
+
+    for (size_t b = 0; b < graph.blocks.size(); b++) {
+        vector<quadruple *> &quads = graph.blocks[b].quads;
+        for (size_t i = 0; i < quads.size(); i++) {
+            sym_index uses[2];
+            int nr_uses = flow_graph::used_symbols(quads[i], uses);
+            for (int u = 0; u < nr_uses; u++) {
+                int v = graph.variable_number(uses[u]);
+                if (v >= 0 && !kill[b][v]) {
+                    gen[b][v] = true;
+                }
+            }
+            if (quads[i]->op_code == q_call) {
+                for (int v = 0; v < nr_variables; v++) {
+                    if (!kill[b][v] &&
+                        seen_by_call(quads[i], graph.variables[v])) {
+                        gen[b][v] = true;
+                    }
+                }
+            }
+            int v = graph.variable_number(flow_graph::defined_symbol(quads[i]));
+            if (v >= 0) {
+                kill[b][v] = true;
+            }
+        }
+    }
+
+    fact_set boundary(nr_variables, false);
+    for (int v = 0; v < nr_variables; v++) {
+        sym_index sym_p = graph.variables[v];
+        boundary[v] = !sym_tab->is_temp(sym_p) &&
+            sym_tab->get_symbol_level(sym_p) <= outer_level;
+    }
+    solve(false, true, boundary);
+}
+
+
+bool liveness::live_in(int block, sym_index sym_p)
+{
+    int v = graph.variable_number(sym_p);
+    return v >= 0 && in[block][v];
+}
+
+
+bool liveness::live_out(int block, sym_index sym_p)
+{
+    int v = graph.variable_number(sym_p);
+    return v >= 0 && out[block][v];
+}
+
+
+static void print_blocks(ostream &o, const vector<int> &blocks)
+{
+    if (blocks.empty()) {
+        o << " -";
+    }
+    for (size_t i = 0; i < blocks.size(); i++) {
+        o << " " << blocks[i];
+    }
+}
+
+
+static void print_variables(ostream &o, flow_graph &graph, const fact_set &live)
+{
+    bool none = true;
+    for (size_t v = 0; v < live.size(); v++) {
+        if (live[v]) {
+            o << " " << sym_ref(graph.variables[v]);
+            none = false;
+        }
+    }
+    if (none) {
+        o << " -";
+    }
+    o << endl;
+}
+
+
+/* The quads are numbered through the blocks, as in a quad list. */
+void liveness::print(ostream &o)
+{
+    o << short_symbols;
+
+    int quad_nr = 1;
+    for (size_t b = 0; b < graph.blocks.size(); b++) {
+        basic_block &block = graph.blocks[b];
+        o << "Block " << b << ", from:";
+        print_blocks(o, block.pred);
+        o << ", to:";
+        print_blocks(o, block.succ);
+        o << endl << "  Live in:";
+        print_variables(o, graph, in[b]);
+        for (size_t i = 0; i < block.quads.size(); i++) {
+            o << setw(5) << quad_nr++ << block.quads[i] << endl;
+        }
+        o << "  Live out:";
+        print_variables(o, graph, out[b]);
+    }
+
+    o << long_symbols;
+}
+
+
+
+/*** Reaching definitions. ***/
+
+/* Only the last definition of a variable in a block reaches its end, and
+   it kills the definitions of the variable in other blocks. */
+reaching_definitions::reaching_definitions(flow_graph &g) :
+    dataflow_analysis(g)
+{
+    vector<vector<int> > defined_by(graph.variables.size());
+    for (size_t b = 0; b < graph.blocks.size(); b++) {
+        vector<quadruple *> &quads = graph.blocks[b].quads;
+        for (size_t i = 0; i < quads.size(); i++) {
+            int v = graph.variable_number(flow_graph::defined_symbol(quads[i]));
+            if (v >= 0) {
+                defined_by[v].push_back(definitions.size());
+            }
+            if (v >= 0 || quads[i]->op_code == q_call) {
+                definitions.push_back(quads[i]);
+            }
+        }
+    }
+    init_sets(definitions.size());
+
+    int d = 0;
+    for (size_t b = 0; b < graph.blocks.size(); b++) {
+        vector<quadruple *> &quads = graph.blocks[b].quads;
+        for (size_t i = 0; i < quads.size(); i++) {
+            if (d == (int) definitions.size() || definitions[d] != quads[i]) {
+                continue;
+            }
+            int v = graph.variable_number(flow_graph::defined_symbol(quads[i]));
+            if (v >= 0) {
+                for (size_t k = 0; k < defined_by[v].size(); k++) {
+                    gen[b][defined_by[v][k]] = false;
+                    kill[b][defined_by[v][k]] = true;
+                }
+            }
+            gen[b][d] = true;
+            d++;
+        }
+    }
+
+    solve(true, true, fact_set(definitions.size(), false));
+}
+
+
+void reaching_definitions::print(ostream &o)
+{
+    // Number the definitions as the quads are numbered through the blocks.
+    vector<int> numbers;
+    int quad_nr = 1;
+    for (size_t b = 0; b < graph.blocks.size(); b++) {
+        vector<quadruple *> &quads = graph.blocks[b].quads;
+        for (size_t i = 0; i < quads.size(); i++, quad_nr++) {
+            if (numbers.size() < definitions.size() &&
+                definitions[numbers.size()] == quads[i]) {
+                numbers.push_back(quad_nr);
+            }
+        }
+    }
+
+    for (size_t b = 0; b < graph.blocks.size(); b++) {
+        vector<int> reaching;
+        for (size_t d = 0; d < definitions.size(); d++) {
+            if (in[b][d]) {
+                reaching.push_back(numbers[d]);
+            }
+        }
+        o << "Block " << b << ", reached by:";
+        print_blocks(o, reaching);
+        o << endl;
+    }
+}
+
+
+
+/*** Dominators. ***/
+
+/* A block dominates itself, and the blocks dominated by all the blocks
+   before it. */
+dominators::dominators(flow_graph &g) :
+    dataflow_analysis(g)
+{
+    init_sets(graph.blocks.size());
+    for (size_t b = 0; b < graph.blocks.size(); b++) {
+        gen[b][b] = true;
+    }
+    solve(true, false, fact_set(graph.blocks.size(), false));
+}
+
+
+bool dominators::dominates(int a, int b)
+{
+    return out[b][a];
+}
+
+
+void dominators::print(ostream &o)
+{
+    int nr_blocks = graph.blocks.size();
+    for (int b = 0; b < nr_blocks; b++) {
+        vector<int> dominating;
+        for (int a = 0; a < nr_blocks; a++) {
+            if (dominates(a, b)) {
+                dominating.push_back(a);
+            }
+        }
+        o << "Block " << b << ", dominated by:";
+        print_blocks(o, dominating);
+        o << endl;
+    }
+}
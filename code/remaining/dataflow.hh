@@ -0,0 +1,109 @@
+#ifndef __DATAFLOW_HH__
+#define __DATAFLOW_HH__
+
+#include "flowgraph.hh"
+
+
+/*** Dataflow analyses over the basic blocks of a flow graph. An analysis
+     finds a set of facts at the start and at the end of each block, such
+     as the variables that are live there or the definitions that reach
+     it. The quads of a block generate some facts and kill others, and
+     where blocks meet, a fact holds if it holds on any of the paths, or
+     only if it holds on all of them, depending on the analysis. Facts are
+     numbered and kept as bit vectors.
+
+     The solver goes over the blocks, forwards or backwards, until nothing
+     changes. A new analysis is a subclass that fills in gen and kill for
+     each block and calls solve(). ***/
+
+
+/* A set of facts, by number. */
+typedef vector<bool> fact_set;
+
+
+class dataflow_analysis
+{
+protected:
+    flow_graph &graph;
+
+    // The facts each block generates and kills.
+    vector<fact_set> gen;
+    vector<fact_set> kill;
+
+    // Gives every block empty gen and kill sets of a number of facts.
+    void init_sets(int nr_facts);
+
+    /*!
+      Finds in and out for every block. Going forward, the facts at the
+      start of a block come from the end of the blocks before it, and the
+      entry block starts with the boundary facts. Going backward, they come
+      from the start of the blocks after it, and a block that leaves the
+      quads ends with the boundary facts. With any_path the facts of the
+      blocks are joined, otherwise only the facts common to all of them are
+      kept.
+     */
+    void solve(bool forward, bool any_path, const fact_set &boundary);
+
+public:
+    dataflow_analysis(flow_graph &);
+
+    //! The facts at the start and at the end of each block.
+    vector<fact_set> in;
+    vector<fact_set> out;
+};
+
+
+/*** The variables that are live, that is, that may be read before they are
+     assigned again. Fact i is that variable i of the flow graph is live.
+     A call reads all the variables the procedure can see, and the
+     variables declared outside the block of the program are live at its
+     end. ***/
+class liveness : public dataflow_analysis
+{
+public:
+    //! Finds the live variables. Variables on outer_level and below are live at the end.
+    liveness(flow_graph &, block_level outer_level);
+
+    //! True if a variable is live at the start or at the end of a block.
+    bool live_in(int block, sym_index);
+    bool live_out(int block, sym_index);
+
+    //! Prints the blocks, their edges and quads, and the variables live into and out of them.
+    void print(ostream &);
+};
+
+
+/*** The definitions that may reach each block without the variable being
+     assigned again. Fact i is that definitions[i] reaches. A call defines
+     all the variables the procedure can see, but since it need not assign
+     them, it kills no other definitions. ***/
+class reaching_definitions : public dataflow_analysis
+{
+public:
+    //! The quads that assign a variable, and the calls.
+    vector<quadruple *> definitions;
+
+    reaching_definitions(flow_graph &);
+
+    //! Prints the definitions reaching each block, numbered as liveness::print() numbers the quads.
+    void print(ostream &);
+};
+
+
+/*** The blocks that dominate each block, that is, that every path from
+     the entry to the block goes through. Fact i is that block i dominates.
+     Blocks that can not be reached are dominated by all blocks. ***/
+class dominators : public dataflow_analysis
+{
+public:
+    dominators(flow_graph &);
+
+    //! True if block a dominates block b.
+    bool dominates(int a, int b);
+
+    //! Prints the blocks that dominate each block.
+    void print(ostream &);
+};
+
+
+#endif
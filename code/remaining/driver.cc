@@ -0,0 +1,374 @@
+#include <atomic>
+#include <sstream>
+#include <thread>
+#include "driver.hh"
+#include "semantic.hh"
+#include "optimize.hh"
+#include "quadopt.hh"
+#include "dataflow.hh"
+#include "codegen.hh"
+
+/* Defined in codegen.cc. */
+extern code_generator *code_gen;
+
+compiler_driver *driver = new compiler_driver();
+
+/* All these defined in main.cc. They represent some of the flags
+   given to the 'diesel' script. */
+extern bool print_ast;
+extern bool print_quads;
+extern bool print_flow_graphs;
+extern bool typecheck;
+extern bool optimize;
+extern bool optimize_quads;
+extern bool fold_while_checking;
+extern bool quads;
+extern bool assembler;
+
+
+/* Constructor. */
+compiler_driver::compiler_driver()
+{
+    whole_program = false;
+    jobs = 1;
+    program_parsed = false;
+}
+
+
+/* Print how a block is named in the trace output. */
+static ostream &block_name(ostream &o, program_block &block)
+{
+    if (block.global) {
+        return o << "global level";
+    }
+    return o << "\"" << sym_tab->pool_lookup(sym_tab->get_symbol(block.env)->id)
+             << "\"";
+}
+
+
+/* True if constants are folded by the type checker, rather than by an
+   optimization pass of their own. */
+static bool folded_by_type_checker()
+{
+    return fold_while_checking && typecheck && optimize;
+}
+
+
+/* Type check a block. The status variables here depend on what flags
+   were passed to the compiler. See the 'diesel' script for more
+   information. */
+void compiler_driver::typecheck_block(program_block &block)
+{
+    if (folded_by_type_checker()) {
+        type_checker->do_typecheck_and_fold(sym_tab->get_symbol(block.env),
+                                            block.body);
+    } else if (typecheck) {
+        type_checker->do_typecheck(sym_tab->get_symbol(block.env),
+                                   block.body);
+    }
+}
+
+
+/* Optimize a block, printing its AST before and after if asked to. If the
+   type checker has folded the constants already, there is no unoptimized
+   AST left to print. */
+void compiler_driver::optimize_block(program_block &block, ostream &o)
+{
+    if (print_ast && !folded_by_type_checker()) {
+        block_name(o << "\nUnoptimized AST for ", block) << endl;
+        o << block.body << endl;
+    }
+
+    if (optimize) {
+        if (!folded_by_type_checker()) {
+            optimizer->do_optimize(block.body);
+        }
+        if (print_ast) {
+            block_name(o << "\nOptimized AST for ", block) << endl;
+            o << block.body << endl;
+        }
+    }
+}
+
+
+/* Make the quads for a block, or return NULL if no quads are to be made.
+   The nodes of the block are released as soon as its quads have been
+   made. */
+quad_list *compiler_driver::make_quads(program_block &block)
+{
+    if (!quads) {
+        return NULL;
+    }
+
+    quad_list *q;
+    if (block.func_head != NULL) {
+        q = block.func_head->do_quads(block.body);
+    } else {
+        q = block.proc_head->do_quads(block.body);
+    }
+    release_block(block);
+    return q;
+}
+
+
+/* Generate assembler code for a block from its quads, if it has any. If
+   asked to, the quads are optimized first. */
+void compiler_driver::generate_block(program_block &block, quad_list *q,
+                                     ostream &o, code_generator *cg)
+{
+    if (q == NULL) {
+        return;
+    }
+
+    if (print_quads) {
+        block_name(o << "\nQuad list for ", block) << endl;
+        o << q << endl;
+    }
+
+    if (optimize && optimize_quads) {
+        quad_optimizer quad_opt(q);
+        quad_opt.propagate_constants();
+        quad_opt.eliminate_common_subexpressions();
+        q = quad_opt.get_quads();
+        if (print_quads) {
+            block_name(o << "\nOptimized quad list for ", block) << endl;
+            o << q << endl;
+        }
+    }
+
+    if (print_flow_graphs) {
+        flow_graph graph(q);
+        liveness live(graph, sym_tab->get_symbol_level(block.env));
+        reaching_definitions reaching(graph);
+        dominators dom(graph);
+        block_name(o << "\nFlow graph for ", block) << endl;
+        live.print(o);
+        o << "Reaching definitions:" << endl;
+        reaching.print(o);
+        o << "Dominators:" << endl;
+        dom.print(o);
+        o << endl;
+    }
+
+    if (assembler) {
+        if (block.global) {
+            o << "Generating assembler, global level" << endl;
+        } else {
+            block_name(o << "Generating assembler for "
+                         << (block.func_head != NULL ?
+                             "function " : "procedure "), block) << endl;
+        }
+        cg->generate_assembler(q, sym_tab->get_symbol(block.env));
+    }
+}
+
+
+/* Optimize and generate code for the kept blocks on jobs threads. Each
+   block gets its own labels and temporaries, see new_backend_space(), and
+   its own buffers for printouts and code. Once all threads are done, the
+   buffers are written in block order, the ASTs first as with one thread.
+   Each block's labels are then numbered after those of the blocks before
+   it, so which thread a block ended up on makes no difference to the
+   output. */
+void compiler_driver::run_backend_threads()
+{
+    size_t count = blocks.size();
+    vector<backend_space *> spaces(count);
+    vector<string> ast_printouts(count);
+    vector<label_buffer> printouts(count);
+    vector<label_buffer> code(count);
+    atomic<size_t> next_block(0);
+
+    for (size_t i = 0; i < count; i++) {
+        spaces[i] = sym_tab->new_backend_space(blocks[i].env);
+    }
+
+    vector<thread> threads;
+    for (int t = 0; t < jobs && (size_t) t < count; t++) {
+        threads.push_back(thread([&]() {
+            size_t i;
+            while ((i = next_block++) < count) {
+                ostringstream ast_o;
+                ostream o(&printouts[i]);
+                code_generator cg(&code[i]);
+                sym_tab->use_backend_space(spaces[i]);
+                ast_arena::set_current(blocks[i].arena);
+                optimize_block(blocks[i], ast_o);
+                generate_block(blocks[i], make_quads(blocks[i]), o, &cg);
+                ast_arena::set_current(NULL);
+                sym_tab->use_backend_space(NULL);
+                ast_printouts[i] = ast_o.str();
+            }
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        cout << ast_printouts[i];
+    }
+    for (size_t i = 0; i < count; i++) {
+        long shift = sym_tab->take_backend_labels(spaces[i]);
+        printouts[i].write_to(cout, shift);
+        code_gen->append_code(code[i], shift);
+    }
+    cout << flush;
+}
+
+
+/* Give a new block an arena and make it current. */
+void compiler_driver::begin_block(sym_index env)
+{
+    open_envs.push_back(env);
+    open_arenas.push_back(new ast_arena());
+    ast_arena::set_current(open_arenas.back());
+}
+
+
+/* Compile a block right away, or keep it for compile_program(). Its arena
+   is taken off the open ones. If the parser gave up on a block nested in
+   it, that one is still open; its nodes may have ended up anywhere, so
+   they are kept along with this block's. */
+void compiler_driver::add_block(program_block &block)
+{
+    if (block.global) {
+        program_parsed = true;
+    }
+
+    while (open_envs.back() != block.env) {
+        ast_arena *abandoned = open_arenas.back();
+        open_envs.pop_back();
+        open_arenas.pop_back();
+        open_arenas.back()->adopt(abandoned);
+        delete abandoned;
+    }
+    block.arena = open_arenas.back();
+    open_envs.pop_back();
+    open_arenas.pop_back();
+    ast_arena::set_current(open_arenas.empty() ? NULL : open_arenas.back());
+
+    if (whole_program) {
+        blocks.push_back(block);
+        return;
+    }
+
+    ast_arena::set_current(block.arena);
+    typecheck_block(block);
+    optimize_block(block, cout);
+    if (error_count == 0) {
+        generate_block(block, make_quads(block), cout, code_gen);
+    }
+    ast_arena::set_current(open_arenas.empty() ? NULL : open_arenas.back());
+    release_block(block);
+}
+
+
+/* Resume a kept block's scope and put new nodes in its arena. */
+void compiler_driver::enter_block(program_block &block)
+{
+    sym_tab->resume_scope(block.env);
+    ast_arena::set_current(block.arena);
+}
+
+
+/* Leave the block enter_block() entered. */
+void compiler_driver::leave_block()
+{
+    ast_arena::set_current(NULL);
+    sym_tab->leave_resumed_scope();
+}
+
+
+/* Free the nodes of a block. Nothing may refer to them anymore. */
+void compiler_driver::release_block(program_block &block)
+{
+    if (block.arena != NULL && ast_arena::current() == block.arena) {
+        ast_arena::set_current(NULL);
+    }
+    delete block.arena;
+    block.arena = NULL;
+}
+
+
+/* Hand over a procedure block, or the program's. */
+void compiler_driver::add_block(ast_procedurehead *head, ast_stmt_list *body,
+                                bool global)
+{
+    program_block block;
+    block.proc_head = head;
+    block.func_head = NULL;
+    block.env = head->sym_p;
+    block.body = body;
+    block.global = global;
+    add_block(block);
+}
+
+
+/* Hand over a function block. */
+void compiler_driver::add_block(ast_functionhead *head, ast_stmt_list *body)
+{
+    program_block block;
+    block.proc_head = NULL;
+    block.func_head = head;
+    block.env = head->sym_p;
+    block.body = body;
+    block.global = false;
+    add_block(block);
+}
+
+
+/* Compile the kept blocks, a phase at a time, and report any errors. The
+   blocks' scopes have been closed by now, so each one is resumed while
+   it is worked on. The error count is only reported for a program that
+   was parsed to its end. */
+void compiler_driver::compile_program()
+{
+    // With several threads, optimization goes with code generation, as
+    // long as there are no errors that stop the latter.
+    bool threaded = jobs > 1;
+
+    for (size_t i = 0; i < blocks.size(); i++) {
+        enter_block(blocks[i]);
+        typecheck_block(blocks[i]);
+        if (!threaded) {
+            optimize_block(blocks[i], cout);
+        }
+        leave_block();
+    }
+
+    if (threaded && error_count != 0) {
+        threaded = false;
+        for (size_t i = 0; i < blocks.size(); i++) {
+            enter_block(blocks[i]);
+            optimize_block(blocks[i], cout);
+            leave_block();
+        }
+    }
+
+    if (threaded) {
+        run_backend_threads();
+    } else if (error_count == 0) {
+        for (size_t i = 0; i < blocks.size(); i++) {
+            enter_block(blocks[i]);
+            generate_block(blocks[i], make_quads(blocks[i]), cout,
+                           code_gen);
+            leave_block();
+        }
+    } else if (program_parsed) {
+        cout << "Found " << error_count << " errors. "
+             << "Compilation aborted.\n";
+    }
+
+    for (size_t i = 0; i < blocks.size(); i++) {
+        release_block(blocks[i]);
+    }
+    blocks.clear();
+}
+
+
+/* Return the blocks kept in whole-program mode. */
+vector<program_block> &compiler_driver::get_blocks()
+{
+    return blocks;
+}
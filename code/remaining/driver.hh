@@ -0,0 +1,135 @@
+#ifndef __DRIVER_HH__
+#define __DRIVER_HH__
+
+#include <vector>
+#include "ast.hh"
+#include "codegen.hh"
+
+
+/*** This class runs the compiler phases over the blocks of the program.
+     By default the parser hands each block over as soon as its production
+     has been reduced, and it is compiled right away, before the rest of
+     the program has been seen. In whole-program mode the blocks are kept
+     instead, together with the symbol table, and compiled once the whole
+     program has been parsed: each phase is then run over all of them
+     before the next one starts, so a phase can look at every block. ***/
+
+
+class compiler_driver;
+
+// Defined in driver.cc.
+extern compiler_driver *driver;
+
+
+/* A block of the program: the head of a procedure, a function or the
+   program itself, and its body. */
+class program_block
+{
+public:
+    //! The head of a procedure or the program, NULL for a function.
+    ast_procedurehead *proc_head;
+    //! The head of a function, NULL otherwise.
+    ast_functionhead  *func_head;
+    //! The procedure or function symbol of the block.
+    sym_index          env;
+    ast_stmt_list     *body;
+    //! True for the body of the program itself.
+    bool               global;
+    //! Holds the nodes of the block, until it has been turned into quads.
+    ast_arena         *arena;
+};
+
+
+class compiler_driver
+{
+private:
+    // The blocks kept in whole-program mode, in the order they were
+    // parsed: nested blocks before the ones they are declared in.
+    vector<program_block> blocks;
+
+    // Set once the body of the program itself has been handed over.
+    bool program_parsed;
+
+    // The blocks being parsed, innermost last, and the arenas their nodes
+    // go in.
+    vector<sym_index> open_envs;
+    vector<ast_arena *> open_arenas;
+
+    // Compile a block right away, or keep it for compile_program().
+    void add_block(program_block &);
+
+    // Make a kept block's scope and arena current, and go back.
+    void enter_block(program_block &);
+    void leave_block();
+
+    // Free the nodes of a block.
+    void release_block(program_block &);
+
+    // Type check a block.
+    void typecheck_block(program_block &);
+
+    // Optimize a block, printing its AST to the stream if asked to.
+    void optimize_block(program_block &, ostream &);
+
+    // Make the quads for a block, or NULL if no quads are to be made.
+    quad_list *make_quads(program_block &);
+
+    // Generate assembler code for a block from its quads with a generator,
+    // printing its quads and progress to the stream.
+    void generate_block(program_block &, quad_list *, ostream &,
+                        code_generator *);
+
+    // Optimize and generate code for all kept blocks on worker threads.
+    void run_backend_threads();
+
+public:
+    //! Keep the blocks until compile_program() instead of compiling each one when it has been parsed.
+    bool whole_program;
+
+    /*! The number of threads to optimize and generate code on, in
+      whole-program mode. With more than one, each thread takes the next
+      block that is left, and the output is put together in block order
+      once they are all done. */
+    int jobs;
+
+    compiler_driver();
+
+    /*! \brief Starts a new block.
+
+    Called by the parser right after a procedure, function or the program
+    has been entered in the symbol table, before the head node is made.
+    The nodes of the block are placed in an arena of its own from here
+    until the block is handed over with add_block().
+    \param env the procedure or function symbol of the block.
+    */
+    void begin_block(sym_index env);
+
+    /*! \brief Hands a parsed procedure or program block over to be compiled.
+
+    Called by the parser when the production for a block is reduced,
+    while the block's scope is still open.
+    \param head the head of the procedure or program.
+    \param body the statements of the block.
+    \param global true for the body of the program itself.
+    */
+    void add_block(ast_procedurehead *head, ast_stmt_list *body, bool global);
+
+    //! Hands a parsed function block over to be compiled.
+    void add_block(ast_functionhead *head, ast_stmt_list *body);
+
+    /*! \brief Finishes compiling the program.
+
+    Called once the parser is done. In whole-program mode, this is where
+    the blocks are compiled, all of them a phase at a time. The blocks
+    that were parsed before a syntax error that the parser could not
+    recover from are compiled too, so that their errors are reported
+    just as when each block is compiled right away.
+    */
+    void compile_program();
+
+    //! Returns the blocks kept in whole-program mode, until compile_program() is done with them.
+    vector<program_block> &get_blocks();
+};
+
+
+#endif
@@ -11,6 +11,25 @@
 int error_count = 0;
 
 
+/* Print the line and column of a position, naming the file if it was
+   included. The location is resolved only once. */
+static ostream &print_line(ostream &o, position_information pos,
+                           const char *column)
+{
+    const char *name;
+    int line, col;
+    pos.resolve(&name, &line, &col);
+    o << line;
+    if (name != NULL) {
+        o << " of " << name;
+    }
+    if (column != NULL) {
+        o << column << col;
+    }
+    return o;
+}
+
+
 /* General error outstream. */
 ostream &error(string header)
 {
@@ -20,10 +39,9 @@ ostream &error(string header)
 
 
 /* Error outstream with position information given. */
-ostream &error(position_information *pos)
+ostream &error(position_information pos)
 {
-    return error("Error") << " line " << pos->get_line()
-           << ", col " << pos->get_column() << ": ";
+    return print_line(error("Error") << " line ", pos, ", col ") << ": ";
 }
 
 
@@ -37,11 +55,12 @@ void fatal(string msg)
 
 /* Used for parser errors. Bison uses this for parse errors not caught by
    the grammar, so it's useful to at least include the line number. Since
-   the error is not one we've accounted for, we don't have access to any
-   position_information. NOTE: Fix scanner.l so it catches weird syntax? */
+   the error is not one we've accounted for, we only have the position the
+   scanner has got to. NOTE: Fix scanner.l so it catches weird syntax? */
 void yyerror(string msg)
 {
-    error() << "line " << yylineno << ": " << msg << endl << flush;
+    print_line(error() << "line ", position_information(scanned_location()),
+               NULL) << ": " << msg << endl << flush;
 }
 
 /* Type conflict error outstream. */
@@ -52,14 +71,9 @@ ostream &type_error()
 
 
 /* Same as above, but with position information given as well. */
-ostream &type_error(position_information *pos)
+ostream &type_error(position_information pos)
 {
-    if (pos == NULL) {
-        return type_error();
-    }
-    return error("Type conflict, line ") << pos->get_line()
-           << ", col " << pos->get_column()
-           << ": ";
+    return print_line(error("Type conflict, line "), pos, ", col ") << ": ";
 }
 
 
@@ -71,44 +85,70 @@ ostream &debug(string header)
 
 
 /* General trace print function, used for debugging. */
-ostream &debug(position_information *pos)
+ostream &debug(position_information pos)
 {
-    if (pos == NULL) {
-        return debug();
-    }
-    return debug("Debug") << " (line " << pos->get_line()
-           << ", col " << pos->get_column() << "): ";
+    return print_line(debug("Debug") << " (line ", pos, ", col ") << "): ";
 }
 
 
 
 /*** Function bodies for the position_information class. ***/
 
-/* Default constructor for position information. */
+/* Default constructor for position information: an unknown position. */
 position_information::position_information()
 {
-    line = 0;
-    column = 0;
+    location = 0;
+}
+
+
+/* Constructor for position information with a location given. */
+position_information::position_information(unsigned int l)
+{
+    location = l;
+}
+
+
+/* Get the source location. */
+unsigned int position_information::get_location()
+{
+    return location;
+}
+
+
+/* Get the file, line and column of the position. They are worked out
+   from the location together, since that means searching the source. */
+void position_information::resolve(const char **name, int *line,
+                                   int *column)
+{
+    resolve_location(location, name, line, column);
 }
 
 
-/* Constructor for position information with positions given. */
-position_information::position_information(int l, int c)
+/* Get the name of the included file, or NULL for the main source. */
+const char *position_information::get_file()
 {
-    line = l;
-    column = c;
+    const char *name;
+    int line, column;
+    resolve(&name, &line, &column);
+    return name;
 }
 
 
-/* Get the line number. */
+/* Get the line number, resolving the location. */
 int position_information::get_line()
 {
+    const char *name;
+    int line, column;
+    resolve(&name, &line, &column);
     return line;
 }
 
 
-/* Get the column number. */
+/* Get the column number, resolving the location. */
 int position_information::get_column()
 {
+    const char *name;
+    int line, column;
+    resolve(&name, &line, &column);
     return column;
 }
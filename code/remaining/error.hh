@@ -16,27 +16,43 @@ using namespace std;
 extern int error_count;
 
 // Defined in scanner.cc (the generated file)
-extern int yylineno;
-
-/* This class contains (starting) line and column of a token, and is used to
-   report the positions of errors in the code. */
+extern bool resolve_location(unsigned int, const char **, int *, int *);
+extern unsigned int scanned_location();
+
+/* This class holds the position of a token, and is used to report the
+   positions of errors in the code. It is a single source location: the
+   number of bytes the scanner had read before the token, counting from 1
+   across all source files, so that it is small enough to be passed and
+   stored by value. The scanner turns it into a file, line and column only
+   when asked to, see resolve_location() in scanner.l. Location 0 means
+   that the position is unknown. */
 class position_information
 {
 private:
-    int line;
-
-    int column;
+    unsigned int location;
 
 public:
     position_information();
 
-    position_information(int l, int c);
+    explicit position_information(unsigned int l);
+
+    unsigned int get_location();
+
+    //! Finds the file, line and column of the position all at once.
+    void resolve(const char **name, int *line, int *column);
+
+    //! The name of the included file holding the position, or NULL.
+    const char *get_file();
 
     int get_line();
 
     int get_column();
 };
 
+// The position of the last token scanned. Defined in parser.cc, or by the
+// scanner and symbol table tests.
+extern position_information yylloc;
+
 
 /* Various methods for printing things, with or without position info.
    They are all defined for real in error.cc. */
@@ -49,15 +65,15 @@ extern void yyerror(string);
 
 extern ostream  &error(string header = "Error: ");
 
-extern ostream  &error(position_information *);
+extern ostream  &error(position_information);
 
 extern ostream  &type_error();
 
-extern ostream  &type_error(position_information *);
+extern ostream  &type_error(position_information);
 
 extern ostream  &debug(string header = "Debug: ");
 
-extern ostream  &debug(position_information *);
+extern ostream  &debug(position_information);
 
 
 #endif
@@ -0,0 +1,197 @@
+#include "flowgraph.hh"
+
+
+/* Split a quad list into basic blocks. A label starts a new block, and so
+   does the quad after a jump or a return. Once all the labels are known,
+   each block is linked to the blocks it may be followed by. */
+flow_graph::flow_graph(quad_list *q_list)
+{
+    last_label = q_list->last_label;
+
+    quad_list_iterator it(q_list);
+    bool block_ended = true;
+    for (quadruple *q = it.get_current(); q != NULL; q = it.get_next()) {
+        if (block_ended || (q->op_code == q_labl &&
+                            !blocks.back().quads.empty())) {
+            blocks.push_back(basic_block());
+        }
+        if (q->op_code == q_labl) {
+            label_blocks[q->int1] = blocks.size() - 1;
+        }
+        blocks.back().quads.push_back(q);
+
+        sym_index uses[2];
+        int nr_uses = used_symbols(q, uses);
+        for (int i = 0; i < nr_uses; i++) {
+            add_variable(uses[i]);
+        }
+        add_variable(defined_symbol(q));
+
+        switch (q->op_code) {
+        case q_jmp:
+        case q_jmpf:
+        case q_ireturn:
+        case q_rreturn:
+            block_ended = true;
+            break;
+        default:
+            block_ended = false;
+            break;
+        }
+    }
+
+    for (size_t b = 0; b < blocks.size(); b++) {
+        quadruple *q = blocks[b].quads.back();
+        switch (q->op_code) {
+        case q_jmp:
+        case q_ireturn:
+        case q_rreturn:
+            add_edge(b, block_of_label(q->int1));
+            break;
+        case q_jmpf:
+            add_edge(b, block_of_label(q->int1));
+            if (b + 1 < blocks.size()) {
+                add_edge(b, b + 1);
+            }
+            break;
+        default:
+            if (b + 1 < blocks.size()) {
+                add_edge(b, b + 1);
+            }
+            break;
+        }
+    }
+}
+
+
+/* Link two blocks, unless they already are. A conditional jump to the
+   very next quad would otherwise link them twice. */
+void flow_graph::add_edge(int from, int to)
+{
+    for (size_t i = 0; i < blocks[from].succ.size(); i++) {
+        if (blocks[from].succ[i] == to) {
+            return;
+        }
+    }
+    blocks[from].succ.push_back(to);
+    blocks[to].pred.push_back(from);
+}
+
+
+/* Give a variable a number, if it does not have one. Constants are left
+   out, since their values are known. */
+void flow_graph::add_variable(sym_index sym_p)
+{
+    if (sym_p == NULL_SYM || sym_tab->get_symbol_tag(sym_p) == SYM_CONST) {
+        return;
+    }
+    if (numbers.find(sym_p) == numbers.end()) {
+        numbers[sym_p] = variables.size();
+        variables.push_back(sym_p);
+    }
+}
+
+
+int flow_graph::block_of_label(long label)
+{
+    unordered_map<long, int>::iterator it = label_blocks.find(label);
+    if (it == label_blocks.end()) {
+        fatal("flow_graph::block_of_label(): jump to a missing label.");
+    }
+    return it->second;
+}
+
+
+int flow_graph::variable_number(sym_index sym_p)
+{
+    unordered_map<sym_index, int>::iterator it = numbers.find(sym_p);
+    if (it == numbers.end()) {
+        return -1;
+    }
+    return it->second;
+}
+
+
+/* The operands of each kind of quad are listed in quads.hh. */
+sym_index flow_graph::defined_symbol(quadruple *q)
+{
+    switch (q->op_code) {
+    case q_rstore:
+    case q_istore:
+    case q_rreturn:
+    case q_ireturn:
+    case q_jmp:
+    case q_jmpf:
+    case q_param:
+    case q_labl:
+    case q_nop:
+        return NULL_SYM;
+    default:
+        return q->sym3;
+    }
+}
+
+
+int flow_graph::used_symbols(quadruple *q, sym_index uses[2])
+{
+    sym_index *operands[2];
+    int nr_uses = used_operands(q, operands);
+    for (int i = 0; i < nr_uses; i++) {
+        uses[i] = *operands[i];
+    }
+    return nr_uses;
+}
+
+
+int flow_graph::used_operands(quadruple *q, sym_index *operands[2])
+{
+    switch (q->op_code) {
+    case q_rload:
+    case q_iload:
+    case q_call:
+    case q_jmp:
+    case q_labl:
+    case q_nop:
+        return 0;
+    case q_inot:
+    case q_ruminus:
+    case q_iuminus:
+    case q_rassign:
+    case q_iassign:
+    case q_itor:
+    case q_param:
+        operands[0] = &q->sym1;
+        return 1;
+    case q_rstore:
+    case q_istore:
+        operands[0] = &q->sym1;
+        operands[1] = &q->sym3;
+        return 2;
+    case q_rreturn:
+    case q_ireturn:
+    case q_jmpf:
+    case q_lindex:
+    case q_rrindex:
+    case q_irindex:
+        operands[0] = &q->sym2;
+        return 1;
+    default:
+        operands[0] = &q->sym1;
+        operands[1] = &q->sym2;
+        return 2;
+    }
+}
+
+
+quad_list *flow_graph::get_quads()
+{
+    quad_list *q_list = new quad_list(last_label);
+    for (size_t b = 0; b < blocks.size(); b++) {
+        for (size_t i = 0; i < blocks[b].quads.size(); i++) {
+            if (blocks[b].quads[i] != NULL) {
+                *q_list += blocks[b].quads[i];
+            }
+        }
+    }
+    return q_list;
+}
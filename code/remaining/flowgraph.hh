@@ -0,0 +1,89 @@
+#ifndef __FLOWGRAPH_HH__
+#define __FLOWGRAPH_HH__
+
+#include <unordered_map>
+#include <vector>
+#include "quads.hh"
+
+
+/*** A flow graph splits the quads of a block of the program into basic
+     blocks: runs of quads that control only enters at the top and only
+     leaves at the bottom. A basic block starts at a label, or right after
+     a jump or a return, and its edges lead to the blocks control may go
+     to next. The passes over the quads in quadopt.cc work on it, changing
+     the quads of the basic blocks, and make a new quad list from it once
+     they are done.
+
+     The variables of the quads, that is the temporaries, variables and
+     parameters they use or assign, are numbered from 0 so that a pass can
+     keep what it knows about them in a vector. ***/
+
+
+/* A run of quads that is only entered at its first quad and only left
+   after its last one. */
+class basic_block
+{
+public:
+    //! The quads of the block, in order. A pass removes a quad by setting it to NULL.
+    vector<quadruple *> quads;
+
+    //! The blocks control may go to after this one, and come from before it.
+    vector<int> succ;
+    vector<int> pred;
+};
+
+
+class flow_graph
+{
+private:
+    // The block each label starts.
+    unordered_map<long, int> label_blocks;
+
+    // The numbers of the variables.
+    unordered_map<sym_index, int> numbers;
+
+    void add_edge(int from, int to);
+    void add_variable(sym_index);
+
+public:
+    //! The basic blocks, in the order of the quads. Control enters at the first one.
+    vector<basic_block> blocks;
+
+    //! The label at the end of the quad list, which return quads jump to.
+    long last_label;
+
+    //! The variables of the quads, by number.
+    vector<sym_index> variables;
+
+    //! Splits a quad list into basic blocks and links them.
+    flow_graph(quad_list *);
+
+    //! Returns the block a label starts.
+    int block_of_label(long);
+
+    //! Returns the number of a variable, or -1 for any other operand, such as a constant or an array.
+    int variable_number(sym_index);
+
+    /*!
+      Returns the symbol a quad assigns, or NULL_SYM if it assigns none.
+      A store assigns an array element, and a call to a procedure
+      nothing.
+     */
+    static sym_index defined_symbol(quadruple *);
+
+    /*!
+      Puts the symbols whose values a quad reads in uses, and returns how
+      many there are, at most two. The array of an index quad and the
+      procedure of a call are not counted.
+     */
+    static int used_symbols(quadruple *, sym_index uses[2]);
+
+    //! Like used_symbols(), but points to the operands so that they can be replaced.
+    static int used_operands(quadruple *, sym_index *operands[2]);
+
+    //! Returns a new quad list with the quads left in the blocks, in order.
+    quad_list *get_quads();
+};
+
+
+#endif
@@ -6,6 +6,7 @@
 
 #include "ast.hh"
 #include "parser.hh"
+#include "driver.hh"
 
 using namespace std;
 
@@ -14,15 +15,25 @@ extern bool yydebug;
 bool assembler_trace = false;
 bool print_ast = false;
 bool print_quads = false;
+bool print_flow_graphs = false;
 bool typecheck = true;
 bool optimize = true;
+bool optimize_quads = false;
+bool fold_while_checking = false;
 bool quads = true;
 bool assembler = true;
+bool reclaim_scopes = false;
+
+/* Defined in scanner.cc. */
+extern void open_source(FILE *, const char *);
+extern void close_source();
+extern void add_include_dir(const char *);
+extern void use_token_cache(const char *, bool);
 
 void usage(char *program_name)
 {
     cerr << "Usage:\n"
-         << program_name << " [-acdfpqsty] inputfile\n"
+         << program_name << " [-acdfFgKmOpqrstwy] [-I dir] [-j jobs] [-k dir] inputfile\n"
          << program_name << " [-h?]\n"
          << "Options:\n"
          << "  -h, -?            Shows this message.\n"
@@ -30,10 +41,20 @@ void usage(char *program_name)
          << "  -c                Disable type checking.\n"
          << "  -d                Turn on parser debugging.\n"
          << "  -f                Don't optimize.\n"
+         << "  -F                Fold constants while type checking, in one pass.\n"
+         << "  -g                Print flow graphs with live variables.\n"
+         << "  -I dir            Search dir for included files.\n"
+         << "  -j jobs           Optimize and generate code on jobs threads; implies -w.\n"
+         << "  -k dir            Cache scanned tokens in dir.\n"
+         << "  -K                Print token cache hit or miss and scan time.\n"
+         << "  -m                Print memory statistics.\n"
+         << "  -O                Optimize the quads too.\n"
          << "  -p                Don't generate quads.\n"
          << "  -q                Print quad lists.\n"
+         << "  -r                Free the symbols of each block once it is compiled.\n"
          << "  -s                Don't generate assembler code.\n"
          << "  -t                Include trace printouts in assembler code.\n"
+         << "  -w                Parse the whole program before compiling it.\n"
          << "  -y                Print symbol table.\n";
     exit(1);
 }
@@ -41,9 +62,12 @@ void usage(char *program_name)
 
 int main(int argc, char **argv)
 {
-    char options[] = "acdfpqstyh?";
+    char options[] = "acdfFgI:j:k:KmOpqrstwyh?";
     int option;
     bool print_symtab = false;
+    bool print_memory = false;
+    const char *token_cache_dir = NULL;
+    bool token_cache_timing = false;
 
     extern  FILE *yyin;
 
@@ -69,6 +93,42 @@ int main(int argc, char **argv)
             cout << "No optimization will be done.\n" << flush;
             optimize = false;
             break;
+        case 'F':
+            cout << "Constants will be folded while type checking.\n" << flush;
+            fold_while_checking = true;
+            break;
+        case 'g':
+            cout << "A flow graph will be printed for each block.\n" << flush;
+            print_flow_graphs = true;
+            break;
+        case 'I':
+            add_include_dir(optarg);
+            break;
+        case 'j':
+            driver->jobs = atoi(optarg);
+            if (driver->jobs < 1) {
+                usage(argv[0]);
+            }
+            cout << "Code will be generated on " << driver->jobs
+                 << " threads.\n" << flush;
+            driver->whole_program = true;
+            break;
+        case 'k':
+            cout << "Tokens will be cached in " << optarg << ".\n" << flush;
+            token_cache_dir = optarg;
+            break;
+        case 'K':
+            cout << "Token cache timing will be printed.\n" << flush;
+            token_cache_timing = true;
+            break;
+        case 'm':
+            cout << "Memory statistics will be printed after compilation.\n";
+            print_memory = true;
+            break;
+        case 'O':
+            cout << "The quads will be optimized.\n" << flush;
+            optimize_quads = true;
+            break;
         case 'p':
             cout << "No quads will be generated.\n" << flush;
             quads = false;
@@ -78,6 +138,10 @@ int main(int argc, char **argv)
                  << flush;
             print_quads = true;
             break;
+        case 'r':
+            cout << "Closed scopes will be reclaimed.\n" << flush;
+            reclaim_scopes = true;
+            break;
         case 's':
             cout << "No assembler code will be generated.\n" << flush;
             assembler = false;
@@ -86,6 +150,11 @@ int main(int argc, char **argv)
             cout << "Assembler code will contain quad labels.\n" << flush;
             assembler_trace = true;
             break;
+        case 'w':
+            cout << "The whole program will be parsed before compiling it.\n"
+                 << flush;
+            driver->whole_program = true;
+            break;
         case 'y':
             cout << "Symbol table will be printed after compilation.\n";
             print_symtab = true;
@@ -99,22 +168,38 @@ int main(int argc, char **argv)
         }
     }
 
+    // The blocks are compiled after all scopes have been closed, so their
+    // symbols must be kept.
+    if (driver->whole_program && reclaim_scopes) {
+        cout << "Closed scopes can't be reclaimed when parsing the whole "
+             << "program first.\n" << flush;
+        reclaim_scopes = false;
+    }
+
+    use_token_cache(token_cache_dir, token_cache_timing);
+
     if (optind > argc || optind < argc - 1) {
         usage(argv[0]);
     } else if (optind == argc) {
         yyin = stdin;
+        open_source(yyin, NULL);
     } else {
         yyin = fopen(argv[optind], "r");
         if (yyin == NULL) {
             perror(argv[optind]);
             exit(1);
         }
+        // Scan the file in place if we can; yyin is read otherwise.
+        open_source(yyin, argv[optind]);
     }
 
     // Start the compilation. This is where all the magic is done.
     // This function resides in parser.cc, which is generated by bison from
     // parser.y.
     yyparse();
+    // In whole-program mode, the blocks are compiled here.
+    driver->compile_program();
+    close_source();
 
     // If given the appropriate flag, prints the symbol table after the input
     // has been parsed.
@@ -123,6 +208,15 @@ int main(int argc, char **argv)
         sym_tab->print(1);
     }
 
+    if (print_memory) {
+        sym_tab->print_statistics();
+        ast_arena::print_statistics();
+    }
+
+    // Compilation is done. Free the symbol table and all symbols in bulk.
+    delete sym_tab;
+    sym_tab = NULL;
+
     exit(error_count);
 }
 
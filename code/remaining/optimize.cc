@@ -2,7 +2,7 @@
 
 /*** This file contains all code pertaining to AST optimisation. It currently
      implements a simple optimisation called "constant folding". Most of the
-     methods in this file are empty, or just relay optimize calls downward
+     methods in this file are empty, or just relay the pass downward
      in the AST. If a more powerful AST optimization scheme were to be
      implemented, only methods in this file should need to be changed. ***/
 
@@ -15,7 +15,7 @@ ast_optimizer *optimizer = new ast_optimizer();
 void ast_optimizer::do_optimize(ast_stmt_list *body)
 {
     if (body != NULL) {
-        body->optimize();
+        visit(body);
     }
 }
 
@@ -52,81 +52,48 @@ bool ast_optimizer::is_binrel(ast_expression *node)
     }
 }
 
-/* We overload this method for the various ast_node subclasses that can
-   appear in the AST. By use of virtual (dynamic) methods, we ensure that
-   the correct method is invoked even if the pointers in the AST refer to
-   one of the abstract classes such as ast_expression or ast_statement. */
-void ast_node::optimize()
+/* The methods of the pass follow. visit() looks at the tag of a node to
+   call the right one, even if the pointers in the AST refer to one of the
+   abstract classes such as ast_expression or ast_statement. Nodes that
+   have no method here end up in visit_node(). */
+void ast_optimizer::visit_node(ast_node *node)
 {
-    fatal("Trying to optimize abstract class ast_node.");
+    fatal("Trying to optimize an abstract or unknown AST node.");
 }
 
-void ast_statement::optimize()
-{
-    fatal("Trying to optimize abstract class ast_statement.");
-}
-
-void ast_expression::optimize()
-{
-    fatal("Trying to optimize abstract class ast_expression.");
-}
-
-void ast_lvalue::optimize()
-{
-    fatal("Trying to optimize abstract class ast_lvalue.");
-}
-
-void ast_binaryoperation::optimize()
-{
-    fatal("Trying to optimize abstract class ast_binaryoperation.");
-}
-
-void ast_binaryrelation::optimize()
-{
-    fatal("Trying to optimize abstract class ast_binaryrelation.");
-}
-
-
-
-/*** The optimize methods for the concrete AST classes. ***/
 
 /* Optimize a statement list. */
-void ast_stmt_list::optimize()
+void ast_optimizer::visit_stmt_list(ast_stmt_list *node)
 {
-    if (preceding != NULL) {
-        preceding->optimize();
-    }
-    if (last_stmt != NULL) {
-        last_stmt->optimize();
+    for (int i = 0; i < node->stmts.size(); i++) {
+        visit(node->stmts[i]);
     }
 }
 
 
 /* Optimize a list of expressions. */
-void ast_expr_list::optimize()
+void ast_optimizer::visit_expr_list(ast_expr_list *node)
 {
     /* Your code here */
-    if (preceding != NULL)
-    {
-        preceding->optimize();
-    }
-    if (last_expr != NULL)
+    for (int i = 0; i < node->exprs.size(); i++)
     {
-        last_expr = optimizer->fold_constants(last_expr);
+        if (node->exprs[i] != NULL)
+        {
+            node->exprs[i] = fold_constants(node->exprs[i]);
+        }
     }
 }
 
 /* Optimize an elsif list. */
-void ast_elsif_list::optimize()
+void ast_optimizer::visit_elsif_list(ast_elsif_list *node)
 {
     /* Your code here */
-    if (preceding != NULL)
-    {
-        preceding->optimize();
-    }
-    if (last_elsif != NULL)
+    for (int i = 0; i < node->elsifs.size(); i++)
     {
-        last_elsif->optimize();
+        if (node->elsifs[i] != NULL)
+        {
+            visit(node->elsifs[i]);
+        }
     }
 }
 
@@ -134,15 +101,28 @@ void ast_elsif_list::optimize()
 /* An identifier's value can change at run-time, so we can't perform
    constant folding optimization on it unless it is a constant.
    Thus we just do nothing here. It can be treated in the fold_constants()
-   method, however. */
-void ast_id::optimize()
+   method, however. The same goes for integers, reals and casts, which
+   have no method of their own and end up here. */
+void ast_optimizer::visit_expression(ast_expression *node)
 {
 }
 
-void ast_indexed::optimize()
+void ast_optimizer::visit_indexed(ast_indexed *node)
 {
     /* Your code here */
-    index->optimize();
+    visit(node->index);
+}
+
+/* The values of constant nodes. The tags of the nodes have already been
+   checked, so they can be cast right away. */
+static long integer_value(ast_expression *node)
+{
+    return static_cast<ast_integer *>(node)->value;
+}
+
+static double real_value(ast_expression *node)
+{
+    return static_cast<ast_real *>(node)->value;
 }
 
 /* This convenience method is used to apply constant folding to all
@@ -151,39 +131,51 @@ void ast_indexed::optimize()
 ast_expression *ast_optimizer::fold_constants(ast_expression *node)
 {
     /* Your code here */
-    node->optimize();
+    visit(node);
+    return fold_operation(node);
+}
+
+/* Returns the literal to put in place of an identifier, if it names a
+   constant, or NULL. An undeclared identifier has no symbol. */
+static ast_expression *constant_literal(ast_expression *node)
+{
+    auto symbol = sym_tab->get_symbol(static_cast<ast_id *>(node)->sym_p);
+    if (symbol == NULL || symbol->tag != SYM_CONST)
+    {
+        return NULL;
+    }
+    if (symbol->type == integer_type)
+    {
+        return new ast_integer(node->pos, symbol->get_constant_symbol()->const_value.ival);
+    }
+    if (symbol->type == real_type)
+    {
+        return new ast_real(node->pos, symbol->get_constant_symbol()->const_value.rval);
+    }
+    return NULL;
+}
 
+/* Fold an expression whose operands have already been optimized. Constant
+   identifiers among the operands are replaced by their values first. */
+ast_expression *ast_optimizer::fold_operation(ast_expression *node)
+{
     if (is_binop(node))
     {
-        auto op = node->get_ast_binaryoperation();
+        auto op = static_cast<ast_binaryoperation *>(node);
         if (op->left->tag == AST_ID && op->right->tag != AST_ID)
         {
-            auto symbol = sym_tab->get_symbol(op->left->get_ast_id()->sym_p);
-            if (symbol->tag == SYM_CONST)
+            ast_expression *literal = constant_literal(op->left);
+            if (literal != NULL)
             {
-                if (symbol->type == integer_type)
-                {
-                    op->left = new ast_integer(op->left->pos, symbol->get_constant_symbol()->const_value.ival);
-                }
-                else if (symbol->type == real_type)
-                {
-                    op->left = new ast_real(op->left->pos, symbol->get_constant_symbol()->const_value.rval);
-                }
+                op->left = literal;
             }
         }
         if (op->right->tag == AST_ID && op->left->tag != AST_ID)
         {
-            auto symbol = sym_tab->get_symbol(op->right->get_ast_id()->sym_p);
-            if (symbol->tag == SYM_CONST)
+            ast_expression *literal = constant_literal(op->right);
+            if (literal != NULL)
             {
-                if (symbol->type == integer_type)
-                {
-                    op->right = new ast_integer(op->right->pos, symbol->get_constant_symbol()->const_value.ival);
-                }
-                else if (symbol->type == real_type)
-                {
-                    op->right = new ast_real(op->right->pos, symbol->get_constant_symbol()->const_value.rval);
-                }
+                op->right = literal;
             }
         }
         if ((op->left->tag != AST_INTEGER && op->left->tag != AST_REAL) || (op->right->tag != AST_INTEGER && op->right->tag != AST_REAL))
@@ -195,93 +187,96 @@ ast_expression *ast_optimizer::fold_constants(ast_expression *node)
         case AST_ADD:
             if (op->left->tag == AST_INTEGER && op->right->tag == AST_INTEGER)
             {
-                return new ast_integer(op->pos, op->left->get_ast_integer()->value + op->right->get_ast_integer()->value);
+                return new ast_integer(op->pos, integer_value(op->left) + integer_value(op->right));
             }
             if (op->left->tag == AST_REAL && op->right->tag == AST_INTEGER)
             {
-                return new ast_real(op->pos, op->left->get_ast_real()->value + op->right->get_ast_integer()->value);
+                return new ast_real(op->pos, real_value(op->left) + integer_value(op->right));
             }
             if (op->left->tag == AST_INTEGER && op->right->tag == AST_REAL)
             {
-                return new ast_real(op->pos, op->left->get_ast_integer()->value + op->right->get_ast_real()->value);
+                return new ast_real(op->pos, integer_value(op->left) + real_value(op->right));
             }
             if (op->left->tag == AST_REAL && op->right->tag == AST_REAL)
             {
-                return new ast_real(op->pos, op->left->get_ast_real()->value + op->right->get_ast_real()->value);
+                return new ast_real(op->pos, real_value(op->left) + real_value(op->right));
             }
             break;
         case AST_SUB:
             if (op->left->tag == AST_INTEGER && op->right->tag == AST_INTEGER)
             {
-                return new ast_integer(op->pos, op->left->get_ast_integer()->value - op->right->get_ast_integer()->value);
+                return new ast_integer(op->pos, integer_value(op->left) - integer_value(op->right));
             }
             if (op->left->tag == AST_REAL && op->right->tag == AST_INTEGER)
             {
-                return new ast_real(op->pos, op->left->get_ast_real()->value - op->right->get_ast_integer()->value);
+                return new ast_real(op->pos, real_value(op->left) - integer_value(op->right));
             }
             if (op->left->tag == AST_INTEGER && op->right->tag == AST_REAL)
             {
-                return new ast_real(op->pos, op->left->get_ast_integer()->value - op->right->get_ast_real()->value);
+                return new ast_real(op->pos, integer_value(op->left) - real_value(op->right));
             }
             if (op->left->tag == AST_REAL && op->right->tag == AST_REAL)
             {
-                return new ast_real(op->pos, op->left->get_ast_real()->value - op->right->get_ast_real()->value);
+                return new ast_real(op->pos, real_value(op->left) - real_value(op->right));
             }
             break;
         case AST_MULT:
             if (op->left->tag == AST_INTEGER && op->right->tag == AST_INTEGER)
             {
-                return new ast_integer(op->pos, op->left->get_ast_integer()->value * op->right->get_ast_integer()->value);
+                return new ast_integer(op->pos, integer_value(op->left) * integer_value(op->right));
             }
             if (op->left->tag == AST_REAL && op->right->tag == AST_INTEGER)
             {
-                return new ast_real(op->pos, op->left->get_ast_real()->value * op->right->get_ast_integer()->value);
+                return new ast_real(op->pos, real_value(op->left) * integer_value(op->right));
             }
             if (op->left->tag == AST_INTEGER && op->right->tag == AST_REAL)
             {
-                return new ast_real(op->pos, op->left->get_ast_integer()->value * op->right->get_ast_real()->value);
+                return new ast_real(op->pos, integer_value(op->left) * real_value(op->right));
             }
             if (op->left->tag == AST_REAL && op->right->tag == AST_REAL)
             {
-                return new ast_real(op->pos, op->left->get_ast_real()->value * op->right->get_ast_real()->value);
+                return new ast_real(op->pos, real_value(op->left) * real_value(op->right));
             }
             break;
         case AST_DIVIDE:
             if (op->left->tag == AST_REAL && op->right->tag == AST_INTEGER)
             {
-                return new ast_real(op->pos, op->left->get_ast_real()->value / op->right->get_ast_integer()->value);
+                return new ast_real(op->pos, real_value(op->left) / integer_value(op->right));
             }
             if (op->left->tag == AST_INTEGER && op->right->tag == AST_REAL)
             {
-                return new ast_real(op->pos, op->left->get_ast_integer()->value / op->right->get_ast_real()->value);
+                return new ast_real(op->pos, integer_value(op->left) / real_value(op->right));
             }
             if (op->left->tag == AST_REAL && op->right->tag == AST_REAL)
             {
-                return new ast_real(op->pos, op->left->get_ast_real()->value / op->right->get_ast_real()->value);
+                return new ast_real(op->pos, real_value(op->left) / real_value(op->right));
             }
             break;
         case AST_OR:
             if (op->left->tag == AST_INTEGER && op->right->tag == AST_INTEGER)
             {
-                return new ast_integer(op->pos, op->left->get_ast_integer()->value || op->right->get_ast_integer()->value);
+                return new ast_integer(op->pos, integer_value(op->left) || integer_value(op->right));
             }
             break;
         case AST_AND:
             if (op->left->tag == AST_INTEGER && op->right->tag == AST_INTEGER)
             {
-                return new ast_integer(op->pos, op->left->get_ast_integer()->value && op->right->get_ast_integer()->value);
+                return new ast_integer(op->pos, integer_value(op->left) && integer_value(op->right));
             }
             break;
         case AST_IDIV:
-            if (op->left->tag == AST_INTEGER && op->right->tag == AST_INTEGER)
+            // Division by zero is left for run time.
+            if (op->left->tag == AST_INTEGER && op->right->tag == AST_INTEGER &&
+                integer_value(op->right) != 0)
             {
-                return new ast_integer(op->pos, op->left->get_ast_integer()->value / op->right->get_ast_integer()->value);
+                return new ast_integer(op->pos, integer_value(op->left) / integer_value(op->right));
             }
             break;
         case AST_MOD:
-            if (op->left->tag == AST_INTEGER && op->right->tag == AST_INTEGER)
+            if (op->left->tag == AST_INTEGER && op->right->tag == AST_INTEGER &&
+                integer_value(op->right) != 0)
             {
-                return new ast_integer(op->pos, op->left->get_ast_integer()->value % op->right->get_ast_integer()->value);
+                return new ast_integer(op->pos, integer_value(op->left) % integer_value(op->right));
             }
             break;
 
@@ -293,208 +288,112 @@ ast_expression *ast_optimizer::fold_constants(ast_expression *node)
 }
 
 /* All the binary operations should already have been detected in their parent
-   nodes, so we don't need to do anything at all here. */
-void ast_add::optimize()
+   nodes, so we only need to fold their operands here. */
+void ast_optimizer::visit_binaryoperation(ast_binaryoperation *node)
 {
     /* Your code here */
-    left = optimizer->fold_constants(left);
-    right = optimizer->fold_constants(right);
-}
-
-void ast_sub::optimize()
-{
-    /* Your code here */
-    left = optimizer->fold_constants(left);
-    right = optimizer->fold_constants(right);
-}
-
-void ast_mult::optimize()
-{
-    /* Your code here */
-    left = optimizer->fold_constants(left);
-    right = optimizer->fold_constants(right);
-}
-
-void ast_divide::optimize()
-{
-    /* Your code here */
-    left = optimizer->fold_constants(left);
-    right = optimizer->fold_constants(right);
-}
-
-void ast_or::optimize()
-{
-    /* Your code here */
-    left = optimizer->fold_constants(left);
-    right = optimizer->fold_constants(right);
-}
-
-void ast_and::optimize()
-{
-    /* Your code here */
-    left = optimizer->fold_constants(left);
-    right = optimizer->fold_constants(right);
-}
-
-void ast_idiv::optimize()
-{
-    /* Your code here */
-    left = optimizer->fold_constants(left);
-    right = optimizer->fold_constants(right);
-}
-
-void ast_mod::optimize()
-{
-    /* Your code here */
-    left = optimizer->fold_constants(left);
-    right = optimizer->fold_constants(right);
+    node->left = fold_constants(node->left);
+    node->right = fold_constants(node->right);
 }
 
 /* We can apply constant folding to binary relations as well. */
-void ast_equal::optimize()
-{
-    /* Your code here */
-    left = optimizer->fold_constants(left);
-    right = optimizer->fold_constants(right);
-}
-
-void ast_notequal::optimize()
+void ast_optimizer::visit_binaryrelation(ast_binaryrelation *node)
 {
     /* Your code here */
-    left = optimizer->fold_constants(left);
-    right = optimizer->fold_constants(right);
-}
-
-void ast_lessthan::optimize()
-{
-    /* Your code here */
-    left = optimizer->fold_constants(left);
-    right = optimizer->fold_constants(right);
-}
-
-void ast_greaterthan::optimize()
-{
-    /* Your code here */
-    left = optimizer->fold_constants(left);
-    right = optimizer->fold_constants(right);
+    node->left = fold_constants(node->left);
+    node->right = fold_constants(node->right);
 }
 
 /*** The various classes derived from ast_statement. ***/
 
-void ast_procedurecall::optimize()
+void ast_optimizer::visit_procedurecall(ast_procedurecall *node)
 {
     /* Your code here */
-    if (parameter_list != NULL)
+    if (node->parameter_list != NULL)
     {
-        parameter_list->optimize();
+        visit(node->parameter_list);
     }
 }
 
-void ast_assign::optimize()
+void ast_optimizer::visit_assign(ast_assign *node)
 {
     /* Your code here */
-    rhs = optimizer->fold_constants(rhs);
+    node->rhs = fold_constants(node->rhs);
 }
 
-void ast_while::optimize()
+void ast_optimizer::visit_while(ast_while *node)
 {
     /* Your code here */
-    if (condition != NULL)
+    if (node->condition != NULL)
     {
-        condition = optimizer->fold_constants(condition);
+        node->condition = fold_constants(node->condition);
     }
-    if (body != NULL)
+    if (node->body != NULL)
     {
-        body->optimize();
+        visit(node->body);
     }
 }
 
-void ast_if::optimize()
+void ast_optimizer::visit_if(ast_if *node)
 {
     /* Your code here */
-    if (condition != NULL)
+    if (node->condition != NULL)
     {
-        condition = optimizer->fold_constants(condition);
+        node->condition = fold_constants(node->condition);
     }
-    if (body != NULL)
+    if (node->body != NULL)
     {
-        body->optimize();
+        visit(node->body);
     }
-    if (else_body != NULL)
+    if (node->else_body != NULL)
     {
-        else_body->optimize();
+        visit(node->else_body);
     }
-    if (elsif_list != NULL)
+    if (node->elsif_list != NULL)
     {
-        elsif_list->optimize();
+        visit(node->elsif_list);
     }
 }
 
-void ast_return::optimize()
+void ast_optimizer::visit_return(ast_return *node)
 {
     /* Your code here */
-    if (value != NULL)
+    if (node->value != NULL)
     {
-        value = optimizer->fold_constants(value);
+        node->value = fold_constants(node->value);
     }
 }
 
-void ast_functioncall::optimize()
+void ast_optimizer::visit_functioncall(ast_functioncall *node)
 {
     /* Your code here */
-    if (parameter_list != NULL)
+    if (node->parameter_list != NULL)
     {
-        parameter_list->optimize();
+        visit(node->parameter_list);
     }
 }
 
-void ast_uminus::optimize()
+void ast_optimizer::visit_uminus(ast_uminus *node)
 {
     /* Your code here */
-    expr = optimizer->fold_constants(expr);
+    node->expr = fold_constants(node->expr);
 }
 
-void ast_not::optimize()
+void ast_optimizer::visit_not(ast_not *node)
 {
     /* Your code here */
-    expr = optimizer->fold_constants(expr);
+    node->expr = fold_constants(node->expr);
 }
 
-void ast_elsif::optimize()
+void ast_optimizer::visit_elsif(ast_elsif *node)
 {
     /* Your code here */
-    if (condition != NULL)
+    if (node->condition != NULL)
     {
-        condition = optimizer->fold_constants(condition);
+        node->condition = fold_constants(node->condition);
     }
-    if (body != NULL)
+    if (node->body != NULL)
     {
-        body->optimize();
+        visit(node->body);
     }
 }
-
-void ast_integer::optimize()
-{
-    /* Your code here */
-}
-
-void ast_real::optimize()
-{
-    /* Your code here */
-}
-
-/* Note: See the comment in fold_constants() about casts and folding. */
-void ast_cast::optimize()
-{
-    /* Your code here */
-}
-
-void ast_procedurehead::optimize()
-{
-    fatal("Trying to call ast_procedurehead::optimize()");
-}
-
-void ast_functionhead::optimize()
-{
-    fatal("Trying to call ast_functionhead::optimize()");
-}
@@ -2,6 +2,7 @@
 #define __OPTIMIZE_HH__
 
 #include "ast.hh"
+#include "visitor.hh"
 
 
 /*** This class performs AST optimisation. Currently it only implements a
@@ -9,7 +10,8 @@
      tries to evaluate a binary operation node such as 2 + 5 during compiling,
      replacing it with a single integer node with value 7, or an expression
      only involving constants, such as (assuming FOO = 2) 4 + FOO, replacing
-     the + node with an integer node with the value 6. ***/
+     the + node with an integer node with the value 6. It is a pass over
+     the AST, see visitor.hh. ***/
 
 
 class ast_optimizer;
@@ -18,7 +20,7 @@ class ast_optimizer;
 extern ast_optimizer *optimizer;
 
 
-class ast_optimizer
+class ast_optimizer : public ast_visitor<ast_optimizer>
 {
 /* You might want to add your own methods to this header file when
    solving the optimization lab. */
@@ -41,11 +43,38 @@ public:
     bool is_binrel(ast_expression *);
 
     /*!
-      This is a convenient method used in optimize.cc. It has to be public
-      so the ast_* nodes can access it. Another solution would be to make it
-      a static method in the optimize.cc file... A matter of preference.
+      This is a convenient method used in optimize.cc. It optimizes an
+      expression and returns the node to put in its place, which is a new
+      constant node if the expression could be folded.
      */
     ast_expression *fold_constants(ast_expression *);
+
+    /*!
+      Folds an expression whose operands have already been optimized,
+      without going down the AST: fold_constants() does the rest. The
+      type checker uses it to fold as it goes, see
+      semantic::do_typecheck_and_fold().
+     */
+    ast_expression *fold_operation(ast_expression *);
+
+    // The methods of the pass. See optimize.cc for the method bodies.
+    void visit_node(ast_node *);
+    void visit_stmt_list(ast_stmt_list *);
+    void visit_expr_list(ast_expr_list *);
+    void visit_elsif_list(ast_elsif_list *);
+    void visit_expression(ast_expression *);
+    void visit_indexed(ast_indexed *);
+    void visit_binaryoperation(ast_binaryoperation *);
+    void visit_binaryrelation(ast_binaryrelation *);
+    void visit_procedurecall(ast_procedurecall *);
+    void visit_assign(ast_assign *);
+    void visit_while(ast_while *);
+    void visit_if(ast_if *);
+    void visit_return(ast_return *);
+    void visit_functioncall(ast_functioncall *);
+    void visit_uminus(ast_uminus *);
+    void visit_not(ast_not *);
+    void visit_elsif(ast_elsif *);
 };
 
 
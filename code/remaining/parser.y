@@ -3,6 +3,7 @@
 #include "semantic.hh"
 #include "optimize.hh"
 #include "codegen.hh"
+#include "driver.hh"
 
 /* Defined in parser.cc */
 extern char *yytext;
@@ -26,14 +27,8 @@ extern int yylex();
 /* Defined in error.hh. */
 extern void yyerror(string);
 
-/* All these defined in main.cc. They represent some of the flags
-   given to the 'diesel' script. */
-extern bool print_ast;
-extern bool print_quads;
-extern bool typecheck;
-extern bool optimize;
-extern bool quads;
-extern bool assembler;
+/* Defined in main.cc. */
+extern bool reclaim_scopes;
 
 #define YYDEBUG 1
 
@@ -41,8 +36,17 @@ extern bool assembler;
    some bison warnings at compiler compile time, however. Use as you
    wish. Not mandatory. */
 /* #define YYERROR_VERBOSE */
+
+/* A rule is located where its first symbol is, or right after the symbol
+   before it if it is empty. */
+#define YYLLOC_DEFAULT(Current, Rhs, N) \
+    (Current) = (N) ? YYRHSLOC(Rhs, 1) : YYRHSLOC(Rhs, 0)
 %}
 
+/* Positions are kept as compact source locations rather than line and
+   column ranges, see position_information in error.hh. */
+%define api.location.type {position_information}
+
 
 
 /* The different semantic values that can be returned within the AST. This is
@@ -123,46 +127,8 @@ extern bool assembler;
 
 program         : prog_decl subprog_part comp_stmt T_DOT
                 {
-
-                    symbol *env = sym_tab->get_symbol($1->sym_p);
-
-                    // The status variables here depend on what flags were
-                    // passed to the compiler. See the 'diesel' script for
-                    // more information.
-                    if (typecheck) {
-                        type_checker->do_typecheck(env, $3);
-                    }
-
-                    if (print_ast) {
-                        cout << "\nUnoptimized AST for global level" << endl;
-                        cout << (ast_stmt_list *)$3 << endl;
-                    }
-
-                    if (optimize) {
-                        optimizer->do_optimize($3);
-                        if(print_ast) {
-                            cout << "\nOptimized AST for global level" << endl;
-                            cout << (ast_stmt_list *)$3 << endl;
-                        }
-                    }
-                    if (error_count == 0) {
-                        if (quads) {
-                            quad_list *q = $1->do_quads($3);
-                            if (print_quads) {
-                                cout << "\nQuad list for global level" << endl;
-                                cout << (quad_list *)q << endl;
-                            }
-
-                            if (assembler) {
-                                cout << "Generating assembler, global level"
-                                     << endl;
-                                code_gen->generate_assembler(q, env);
-                            }
-                        }
-                    } else {
-                        cout << "Found " << error_count << " errors. "
-                             << "Compilation aborted.\n";
-                    }
+                    // The phases are run by the driver, see driver.hh.
+                    driver->add_block($1, $3, true);
 
                     // We close the global scope.
                     sym_tab->close_scope();
@@ -179,10 +145,11 @@ prog_decl       : prog_head T_SEMICOLON const_part variable_part
 prog_head       : T_PROGRAM T_IDENT // program identifier
                 {
 
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
 
                     sym_index proc_loc = sym_tab->enter_procedure(pos, $2);
                     sym_tab->open_scope();
+                    driver->begin_block(proc_loc);
 
                     $$ = new ast_procedurehead(pos, proc_loc);
                 }
@@ -202,12 +169,12 @@ const_decls     : const_decl
 
 const_decl      : T_IDENT T_EQ integer T_SEMICOLON
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     sym_tab->enter_constant(pos, $1, integer_type, $3->value);
                 }
                 | T_IDENT T_EQ real T_SEMICOLON
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     sym_tab->enter_constant(pos, $1, real_type, $3->value);
                 }
                 | T_IDENT T_EQ T_STRINGCONST T_SEMICOLON
@@ -222,7 +189,7 @@ const_decl      : T_IDENT T_EQ integer T_SEMICOLON
                     // constant foo = 5;
                     // constant bar = foo;
                     // ...now, why would anyone want to do that?
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     constant_value const_value = sym_tab->get_symbol($3->sym_p)->get_constant_symbol()->const_value;
                     if ($3->type == integer_type)
                     {
@@ -249,22 +216,20 @@ var_decls       : var_decl
 
 var_decl        : T_IDENT T_COLON type_id T_SEMICOLON
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
-                    sym_tab->enter_variable(pos, $1, $3->type_check());
+                    position_information pos = @1;
+                    sym_tab->enter_variable(pos, $1, type_checker->visit($3));
                 }
                 | T_IDENT T_COLON T_ARRAY T_LEFTBRACKET integer T_RIGHTBRACKET T_OF type_id T_SEMICOLON
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
-                    sym_tab->enter_array(pos, $1, $8->type_check(), $5->value);
+                    position_information pos = @1;
+                    sym_tab->enter_array(pos, $1, type_checker->visit($8), $5->value);
                 }
                 | T_IDENT T_COLON T_ARRAY T_LEFTBRACKET const_id T_RIGHTBRACKET T_OF type_id T_SEMICOLON
                 {
                     // We enter an array: pool_pointer, type pointer,
                     // the id type of the constant, and the value of the
                     // constant.
-                    position_information *pos =
-                        new position_information(@1.first_line,
-                                                 @1.first_column);
+                    position_information pos = @1;
 
                     // Ideally we should be able to just enter the array and
                     // defer index type checking to the semantic phase.
@@ -321,99 +286,31 @@ subprog_decls   : subprog_decl
 
 subprog_decl    : proc_decl subprog_part comp_stmt T_SEMICOLON
                 {
-
-                    symbol *env = sym_tab->get_symbol($1->sym_p);
-
-                    if (typecheck) {
-                        type_checker->do_typecheck(env, $3);
-                    }
-
-                    if (print_ast) {
-                        cout << "\nUnoptimized AST for \""
-                             << sym_tab->pool_lookup(env->id)
-                             << "\"" << endl;
-                        cout << (ast_stmt_list *)$3 << endl;
-                    }
-
-                    if (optimize) {
-                        optimizer->do_optimize($3);
-                        if (print_ast) {
-                            cout << "\nOptimized AST for \""
-                                 << sym_tab->pool_lookup(env->id)
-                                 << "\"" << endl;
-                            cout << (ast_stmt_list*)$3 << endl;
-                        }
-                    }
-
-                    if (error_count == 0) {
-                        if (quads) {
-                            quad_list *q = $1->do_quads($3);
-                            if (print_quads) {
-                                cout << "\nQuad list for \""
-                                     << sym_tab->pool_lookup(env->id)
-                                     << "\"" << endl;
-                                cout << (quad_list *)q << endl;
-                            }
-
-                            if (assembler) {
-                                cout << "Generating assembler for procedure \""
-                                     << sym_tab->pool_lookup(env->id)
-                                     << "\"" << endl;
-                                code_gen->generate_assembler(q, env);
-                            }
-                        }
-                    }
+                    driver->add_block($1, $3, false);
 
                     // Close the current scope.
                     sym_tab->close_scope();
+
+                    if (reclaim_scopes) {
+                        // A scanned lookahead identifier may point to a
+                        // string that was installed inside the block.
+                        sym_tab->reclaim_closed_scope(yychar == T_IDENT ||
+                                                      yychar == T_STRINGCONST);
+                    }
                 }
                 | func_decl subprog_part comp_stmt T_SEMICOLON
                 {
-
-                    symbol *env = sym_tab->get_symbol($1->sym_p);
-
-                    if (typecheck) {
-                        type_checker->do_typecheck(env, $3);
-                    }
-
-                    if (print_ast) {
-                        cout << "\nUnoptimized AST for \""
-                             << sym_tab->pool_lookup(env->id)
-                             << "\"" << endl;
-                        cout << (ast_stmt_list *)$3 << endl;
-                    }
-
-                    if (optimize) {
-                        optimizer->do_optimize($3);
-                        if (print_ast) {
-                            cout << "\nOptimized AST for \""
-                                 << sym_tab->pool_lookup(env->id)
-                                 << "\"" << endl;
-                            cout << (ast_stmt_list *)$3 << endl;
-                        }
-                    }
-
-                    if (error_count == 0) {
-                        if (quads) {
-                            quad_list *q = $1->do_quads($3);
-                            if (print_quads) {
-                                cout << "\nQuad list for \""
-                                     << sym_tab->pool_lookup(env->id)
-                                     << "\"" << endl;
-                                cout << (quad_list *)q << endl;
-                            }
-
-                            if (assembler) {
-                                cout << "Generating assembler for function \""
-                                     << sym_tab->pool_lookup(env->id) << "\""
-                                     << endl;
-                                code_gen->generate_assembler(q, env);
-                            }
-                        }
-                    }
+                    driver->add_block($1, $3);
 
                     // Close the current scope.
                     sym_tab->close_scope();
+
+                    if (reclaim_scopes) {
+                        // A scanned lookahead identifier may point to a
+                        // string that was installed inside the block.
+                        sym_tab->reclaim_closed_scope(yychar == T_IDENT ||
+                                                      yychar == T_STRINGCONST);
+                    }
                 }
                 ;
 
@@ -427,8 +324,7 @@ proc_decl       : proc_head opt_param_list T_SEMICOLON const_part variable_part
 
 func_decl       : func_head opt_param_list T_COLON type_id T_SEMICOLON const_part variable_part
                 {
-                    auto tmp = sym_tab->get_symbol($1->sym_p)->get_function_symbol();
-                    tmp->type = $4->type_check();
+                    sym_tab->set_symbol_type($1->sym_p, type_checker->visit($4));
                     
                     $$ = $1;
                 }
@@ -437,14 +333,13 @@ func_decl       : func_head opt_param_list T_COLON type_id T_SEMICOLON const_par
 
 proc_head       : T_PROCEDURE T_IDENT
                 {
-                    position_information *pos =
-                        new position_information(@1.first_line,
-                                                 @1.first_column);
+                    position_information pos = @1;
                     // We add the function id to the symbol table.
                     sym_index proc_loc = sym_tab->enter_procedure(pos,
                                                                   $2);
                     // Open a new scope.
                     sym_tab->open_scope();
+                    driver->begin_block(proc_loc);
                     // This AST node is just a temporary node which we create
                     // here in order to be able to provide the symbol table
                     // index for the procedure to the proc_decl production
@@ -457,14 +352,13 @@ proc_head       : T_PROCEDURE T_IDENT
 
 func_head       : T_FUNCTION T_IDENT
                 {
-                    position_information *pos =
-                        new position_information(@1.first_line,
-                                                 @1.first_column);
+                    position_information pos = @1;
                     // We add the function id to the symbol table.
                     sym_index func_loc = sym_tab->enter_function(pos,
                                                                  $2);
                     // Open a new scope.
                     sym_tab->open_scope();
+                    driver->begin_block(func_loc);
 
                     // This AST node is just a temporary node which we create
                     // here in order to be able to provide the symbol table
@@ -505,9 +399,7 @@ param_list      : param
 
 param           : T_IDENT T_COLON type_id
                 {
-                    position_information *pos =
-                        new position_information(@1.first_line,
-                                                 @1.first_column);
+                    position_information pos = @1;
 
                     // Enter parameter into the symbol table. The linking of
                     // parameters and things is taken care of in the
@@ -530,7 +422,7 @@ comp_stmt       : T_BEGIN stmt_list T_END
 
 stmt_list       : stmt
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     if ($1 != NULL)
                     {
                         $$ = new ast_stmt_list(pos, $1);
@@ -542,12 +434,17 @@ stmt_list       : stmt
                 }
                 | stmt_list T_SEMICOLON stmt
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
-                    if ($3 != NULL) {
-                        $$ = new ast_stmt_list(pos, $3, $1);
+                    position_information pos = @1;
+                    if ($3 == NULL) {
+                        $$ = $1;
+                    }
+                    else if ($1 == NULL)
+                    {
+                        $$ = new ast_stmt_list(pos, $3);
                     }
                     else
                     {
+                        $1->add($3);
                         $$ = $1;
                     }
                 }
@@ -556,7 +453,7 @@ stmt_list       : stmt
 
 stmt            : T_IF expr T_THEN stmt_list elsif_list else_part T_END
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_if(pos, $2, $4, $5, $6);
                 }
                 | T_IF error T_THEN stmt_list elsif_list else_part T_END
@@ -573,7 +470,7 @@ stmt            : T_IF expr T_THEN stmt_list elsif_list else_part T_END
                 }
                 | T_WHILE expr T_DO stmt_list T_END
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_while(pos, $2, $4);
                 }
                 | T_WHILE error T_DO stmt_list T_END
@@ -590,7 +487,7 @@ stmt            : T_IF expr T_THEN stmt_list elsif_list else_part T_END
                 }
                 | proc_id T_LEFTPAR opt_expr_list T_RIGHTPAR
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_procedurecall(pos, $1, $3);
                 }
                 | proc_id T_LEFTPAR error T_RIGHTPAR
@@ -599,7 +496,7 @@ stmt            : T_IF expr T_THEN stmt_list elsif_list else_part T_END
                 }
                 | lvariable T_ASSIGN expr
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_assign(pos, $1, $3);
                 }
                 | lvariable T_ASSIGN error // this breaks parstest2 (improvement)
@@ -608,7 +505,7 @@ stmt            : T_IF expr T_THEN stmt_list elsif_list else_part T_END
                 }
                 | T_RETURN expr
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_return(pos, $2);
                 }
                 | T_RETURN error
@@ -617,7 +514,7 @@ stmt            : T_IF expr T_THEN stmt_list elsif_list else_part T_END
                 }
                 | T_RETURN
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_return(pos);
                 }
                 
@@ -650,7 +547,7 @@ rvariable       : rvar_id
                 }
                 | array_id T_LEFTBRACKET expr T_RIGHTBRACKET
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_indexed(pos, $1, $3);
                 }
                 | array_id T_LEFTBRACKET error T_RIGHTBRACKET
@@ -662,8 +559,13 @@ rvariable       : rvar_id
 
 elsif_list      : elsif_list elsif
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
-                    $$ = new ast_elsif_list(pos, $2, $1);
+                    position_information pos = @1;
+                    if ($1 == NULL) {
+                        $$ = new ast_elsif_list(pos, $2);
+                    } else {
+                        $1->add($2);
+                        $$ = $1;
+                    }
                 }
                 | /* empty */
                 {
@@ -674,7 +576,7 @@ elsif_list      : elsif_list elsif
 
 elsif           : T_ELSIF expr T_THEN stmt_list
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_elsif(pos, $2, $4);
                 }
                 ;
@@ -704,13 +606,13 @@ opt_expr_list   : expr_list
 
 expr_list       : expr
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_expr_list(pos, $1);
                 }
                 | expr_list T_COMMA expr
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
-                    $$ = new ast_expr_list(pos, $3, $1);
+                    $1->add($3);
+                    $$ = $1;
                 }
                 ;
 
@@ -721,22 +623,22 @@ expr            : simple_expr
                 }
                 | expr T_EQ simple_expr
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_equal(pos, $1, $3);
                 }
                 | expr T_NOTEQ simple_expr
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_notequal(pos, $1, $3);
                 }
                 | expr T_LESSTHAN simple_expr
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_lessthan(pos, $1, $3);
                 }
                 | expr T_GREATERTHAN simple_expr
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_greaterthan(pos, $1, $3);
                 }
                 ;
@@ -752,22 +654,22 @@ simple_expr     : term
                 }
                 | T_SUB term
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_uminus(pos, $2);
                 }
                 | simple_expr T_OR term
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_or(pos, $1, $3);
                 }
                 | simple_expr T_ADD term
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_add(pos, $1, $3);
                 }
                 | simple_expr T_SUB term
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_sub(pos, $1, $3);
                 }
                 ;
@@ -779,27 +681,27 @@ term            : factor
                 }
                 | term T_AND factor
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_and(pos, $1, $3);
                 }
                 | term T_MUL factor
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_mult(pos, $1, $3);
                 }
                 | term T_RDIV factor
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_divide(pos, $1, $3);
                 }
                 | term T_IDIV factor
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_idiv(pos, $1, $3);
                 }
                 | term T_MOD factor
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_mod(pos, $1, $3);
                 }
                 ;
@@ -823,7 +725,7 @@ factor          : rvariable
                 }
                 | T_NOT factor
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_not(pos, $2);
                 }
                 | T_LEFTPAR expr T_RIGHTPAR
@@ -836,7 +738,7 @@ factor          : rvariable
 
 func_call       : func_id T_LEFTPAR opt_expr_list T_RIGHTPAR
                 {
-                    position_information *pos = new position_information(@1.first_line, @1.first_column);
+                    position_information pos = @1;
                     $$ = new ast_functioncall(pos, $1, $3);
                 }
                 ;
@@ -844,9 +746,7 @@ func_call       : func_id T_LEFTPAR opt_expr_list T_RIGHTPAR
 
 integer         : T_INTNUM
                 {
-                    position_information *pos =
-                        new position_information(@1.first_line,
-                                                 @1.first_column);
+                    position_information pos = @1;
 
                     // We need to pass on the value AND the position here.
                     $$ = new ast_integer(pos,
@@ -857,9 +757,7 @@ integer         : T_INTNUM
 
 real            : T_REALNUM
                 {
-                    position_information *pos =
-                        new position_information(@1.first_line,
-                                                 @1.first_column);
+                    position_information pos = @1;
 
                     // We create a new real constant.
                     $$ = new ast_real(pos,
@@ -972,9 +870,7 @@ array_id        : id
 id              : T_IDENT
                 {
                     sym_index sym_p;    // Used to find previous use of symbol.
-                    position_information *pos =
-                        new position_information(@1.first_line,
-                                                 @1.first_column);
+                    position_information pos = @1;
 
                     // Make sure the symbol was declared before it is used.
                     sym_p = sym_tab->lookup_symbol($1);
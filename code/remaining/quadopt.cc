@@ -0,0 +1,786 @@
+#include <algorithm>
+#include <limits.h>
+#include <map>
+#include <math.h>
+#include <string.h>
+#include <unordered_map>
+#include "quadopt.hh"
+
+/*** This file contains the optimizations of the quads. They run on the
+     flow graph of a quad list, after do_quads() and before the assembler
+     code is generated. The values of the quads are only looked at, and
+     the quads only changed, the way the code generator would treat them:
+     see codegen.cc for what each quad does at run time. ***/
+
+
+/* The constructor builds the flow graph the optimizations work on. */
+quad_optimizer::quad_optimizer(quad_list *q_list) :
+    graph(q_list)
+{
+}
+
+
+quad_list *quad_optimizer::get_quads()
+{
+    return graph.get_quads();
+}
+
+
+
+/*** Constant propagation. ***/
+
+/* What is known about the value of a variable at some point: nothing
+   yet, that it holds a constant, or that it may vary. Reals are kept as
+   their ieee bits, just like in the quads. */
+enum value_kind {
+    VALUE_UNKNOWN,
+    VALUE_CONSTANT,
+    VALUE_VARYING
+};
+
+struct quad_value
+{
+    value_kind kind;
+    long       bits;
+};
+
+static quad_value varying()
+{
+    quad_value v = { VALUE_VARYING, 0 };
+    return v;
+}
+
+static quad_value constant(long bits)
+{
+    quad_value v = { VALUE_CONSTANT, bits };
+    return v;
+}
+
+static bool same_value(quad_value a, quad_value b)
+{
+    return a.kind == b.kind && (a.kind != VALUE_CONSTANT || a.bits == b.bits);
+}
+
+/* What is known where two paths meet. */
+static quad_value meet(quad_value a, quad_value b)
+{
+    if (a.kind == VALUE_UNKNOWN) {
+        return b;
+    }
+    if (b.kind == VALUE_UNKNOWN || same_value(a, b)) {
+        return a;
+    }
+    return varying();
+}
+
+static double real_of(long bits)
+{
+    double d;
+    memcpy(&d, &bits, sizeof(double));
+    return d;
+}
+
+static long bits_of(double d)
+{
+    long bits;
+    memcpy(&bits, &d, sizeof(long));
+    return bits;
+}
+
+/* True for the quads whose result is a real. */
+static bool has_real_result(quad_op_type op)
+{
+    switch (op) {
+    case q_rload:
+    case q_ruminus:
+    case q_rplus:
+    case q_rminus:
+    case q_rmult:
+    case q_rdivide:
+    case q_rassign:
+    case q_itor:
+        return true;
+    default:
+        return false;
+    }
+}
+
+
+/* Constant propagation is done with the values of the variables that
+   flow into each block: those that are read in a block before they are
+   assigned in it. Starting from the first block, the quads of a block are
+   run with what is known about the variables on entry, which is what is
+   known on exit from the blocks that have been found to lead to it. A
+   conditional jump on a known condition only leads one way. A block is
+   run again whenever what flows into it changes. Since a variable can
+   only go from unknown to constant to varying, this ends, and the blocks
+   that were never reached can not be reached at run time. */
+class constant_propagation
+{
+private:
+    flow_graph &graph;
+
+    // The numbers of the variables that flow into blocks, and the index
+    // of each variable among them, or -1.
+    vector<int> flowing;
+    vector<int> flow_index;
+
+    // The variables a call may change, and their levels. Temporaries
+    // belong to the block alone, but a procedure may assign any variable
+    // it can see.
+    vector<int> call_changes;
+    vector<int> levels;
+
+    // What is known about each variable while a block is being run.
+    vector<quad_value> current;
+
+    // For each block: if it has been reached, from which blocks, and what
+    // was known about the flowing variables on exit from it.
+    vector<bool> reached;
+    vector<vector<int> > reached_from;
+    vector<vector<quad_value> > exit_values;
+
+    quad_value value_of(sym_index);
+    quad_value evaluate(quadruple *);
+    void run_block(int, bool rewrite, vector<int> &next);
+
+public:
+    constant_propagation(flow_graph &);
+
+    // Find the values, then change the quads.
+    void solve();
+    void rewrite();
+};
+
+
+constant_propagation::constant_propagation(flow_graph &g) :
+    graph(g)
+{
+    int nr_variables = graph.variables.size();
+    int nr_blocks = graph.blocks.size();
+
+    // Find the variables that are read before they are assigned in some
+    // block.
+    flow_index.assign(nr_variables, -1);
+    vector<int> assigned_in(nr_variables, -1);
+    for (int b = 0; b < nr_blocks; b++) {
+        vector<quadruple *> &quads = graph.blocks[b].quads;
+        for (size_t i = 0; i < quads.size(); i++) {
+            sym_index uses[2];
+            int nr_uses = flow_graph::used_symbols(quads[i], uses);
+            for (int u = 0; u < nr_uses; u++) {
+                int v = graph.variable_number(uses[u]);
+                if (v >= 0 && assigned_in[v] != b && flow_index[v] < 0) {
+                    flow_index[v] = flowing.size();
+                    flowing.push_back(v);
+                }
+            }
+            int v = graph.variable_number(flow_graph::defined_symbol(quads[i]));
+            if (v >= 0) {
+                assigned_in[v] = b;
+            }
+        }
+    }
+
+    levels.resize(nr_variables);
+    for (int v = 0; v < nr_variables; v++) {
+        if (!sym_tab->is_temp(graph.variables[v])) {
+            call_changes.push_back(v);
+            levels[v] = sym_tab->get_symbol_level(graph.variables[v]);
+        }
+    }
+
+    current.resize(nr_variables);
+    reached.assign(nr_blocks, false);
+    reached_from.resize(nr_blocks);
+    exit_values.resize(nr_blocks);
+}
+
+
+/* The value of an operand. The code generator loads a constant symbol's
+   value directly. Arrays and the like are not numbered, and vary. */
+quad_value constant_propagation::value_of(sym_index sym_p)
+{
+    if (sym_tab->get_symbol_tag(sym_p) == SYM_CONST) {
+        constant_value value = sym_tab->get_const_value(sym_p);
+        if (sym_tab->get_symbol_type(sym_p) == real_type) {
+            return constant(bits_of(value.rval));
+        }
+        return constant(value.ival);
+    }
+    int v = graph.variable_number(sym_p);
+    if (v < 0) {
+        return varying();
+    }
+    return current[v];
+}
+
+
+/* The value a quad assigns, computed the way the code generator does it.
+   Integers wrap around. A division that would trap at run time, and a
+   comparison with a NaN, are left for run time. */
+quad_value constant_propagation::evaluate(quadruple *q)
+{
+    quad_value a;
+    quad_value b;
+
+    switch (q->op_code) {
+    case q_rload:
+    case q_iload:
+        return constant(q->int1);
+
+    case q_inot:
+    case q_ruminus:
+    case q_iuminus:
+    case q_rassign:
+    case q_iassign:
+    case q_itor:
+        a = value_of(q->sym1);
+        if (a.kind != VALUE_CONSTANT) {
+            return a;
+        }
+        switch (q->op_code) {
+        case q_inot:
+            return constant(a.bits == 0);
+        case q_ruminus:
+            return constant(bits_of(-real_of(a.bits)));
+        case q_iuminus:
+            return constant((long) (0UL - (unsigned long) a.bits));
+        case q_itor:
+            return constant(bits_of((double) a.bits));
+        default:
+            return a;
+        }
+
+    case q_rplus:
+    case q_iplus:
+    case q_rminus:
+    case q_iminus:
+    case q_ior:
+    case q_iand:
+    case q_rmult:
+    case q_imult:
+    case q_rdivide:
+    case q_idivide:
+    case q_imod:
+    case q_req:
+    case q_ieq:
+    case q_rne:
+    case q_ine:
+    case q_rlt:
+    case q_ilt:
+    case q_rgt:
+    case q_igt:
+        a = value_of(q->sym1);
+        b = value_of(q->sym2);
+        break;
+
+    default:
+        // Calls and array elements.
+        return varying();
+    }
+
+    if (a.kind == VALUE_VARYING || b.kind == VALUE_VARYING) {
+        return varying();
+    }
+    if (a.kind == VALUE_UNKNOWN || b.kind == VALUE_UNKNOWN) {
+        a.kind = VALUE_UNKNOWN;
+        return a;
+    }
+
+    unsigned long x = a.bits;
+    unsigned long y = b.bits;
+    double rx = real_of(a.bits);
+    double ry = real_of(b.bits);
+    switch (q->op_code) {
+    case q_iplus:
+        return constant((long) (x + y));
+    case q_iminus:
+        return constant((long) (x - y));
+    case q_imult:
+        return constant((long) (x * y));
+    case q_idivide:
+    case q_imod:
+        if (b.bits == 0 || (a.bits == LONG_MIN && b.bits == -1)) {
+            return varying();
+        }
+        if (q->op_code == q_idivide) {
+            return constant(a.bits / b.bits);
+        }
+        return constant(a.bits % b.bits);
+    case q_ior:
+        return constant(a.bits != 0 || b.bits != 0);
+    case q_iand:
+        return constant(a.bits != 0 && b.bits != 0);
+    case q_ieq:
+        return constant(a.bits == b.bits);
+    case q_ine:
+        return constant(a.bits != b.bits);
+    case q_ilt:
+        return constant(a.bits < b.bits);
+    case q_igt:
+        return constant(a.bits > b.bits);
+    case q_rplus:
+        return constant(bits_of(rx + ry));
+    case q_rminus:
+        return constant(bits_of(rx - ry));
+    case q_rmult:
+        return constant(bits_of(rx * ry));
+    case q_rdivide:
+        return constant(bits_of(rx / ry));
+    default:
+        break;
+    }
+
+    if (isnan(rx) || isnan(ry)) {
+        return varying();
+    }
+    switch (q->op_code) {
+    case q_req:
+        return constant(rx == ry);
+    case q_rne:
+        return constant(rx != ry);
+    case q_rlt:
+        return constant(rx < ry);
+    default:
+        return constant(rx > ry);
+    }
+}
+
+
+/* Run the quads of a reached block, and put the blocks it leads to in
+   next. When rewriting, the quads are changed according to what is found:
+   a quad with a known result loads it instead, and a conditional jump on
+   a known condition becomes a jump, or goes away. */
+void constant_propagation::run_block(int b, bool rewrite, vector<int> &next)
+{
+    basic_block &block = graph.blocks[b];
+
+    for (size_t k = 0; k < flowing.size(); k++) {
+        quad_value value = { VALUE_UNKNOWN, 0 };
+        if (b == 0) {
+            // Nothing is known about the variables at the start.
+            value = varying();
+        }
+        for (size_t p = 0; p < reached_from[b].size(); p++) {
+            value = meet(value, exit_values[reached_from[b][p]][k]);
+        }
+        current[flowing[k]] = value;
+    }
+
+    for (size_t i = 0; i < block.quads.size(); i++) {
+        quadruple *q = block.quads[i];
+        if (q->op_code == q_call) {
+            int level = sym_tab->get_symbol_level(q->sym1);
+            for (size_t c = 0; c < call_changes.size(); c++) {
+                if (levels[call_changes[c]] <= level) {
+                    current[call_changes[c]] = varying();
+                }
+            }
+        }
+
+        sym_index sym_p = flow_graph::defined_symbol(q);
+        if (sym_p == NULL_SYM) {
+            continue;
+        }
+        quad_value value = evaluate(q);
+        current[graph.variable_number(sym_p)] = value;
+
+        if (rewrite && value.kind == VALUE_CONSTANT &&
+            q->op_code != q_iload && q->op_code != q_rload) {
+            q->op_code = has_real_result(q->op_code) ? q_rload : q_iload;
+            q->int1 = q->sym1 = value.bits;
+            q->int2 = q->sym2 = NULL_SYM;
+        }
+    }
+
+    next.clear();
+    quadruple *last = block.quads.back();
+    if (last->op_code != q_jmpf) {
+        next = block.succ;
+        return;
+    }
+
+    quad_value condition = value_of(last->sym2);
+    if (condition.kind == VALUE_VARYING) {
+        next = block.succ;
+    } else if (condition.kind == VALUE_CONSTANT && condition.bits != 0) {
+        // The jump is never taken.
+        if (b + 1 < (int) graph.blocks.size()) {
+            next.push_back(b + 1);
+        }
+        if (rewrite) {
+            block.quads.back() = NULL;
+        }
+    } else if (condition.kind == VALUE_CONSTANT) {
+        // The jump is always taken.
+        next.push_back(graph.block_of_label(last->int1));
+        if (rewrite) {
+            last->op_code = q_jmp;
+            last->int2 = last->sym2 = NULL_SYM;
+        }
+    }
+}
+
+
+void constant_propagation::solve()
+{
+    vector<int> worklist(1, 0);
+    vector<bool> queued(graph.blocks.size(), false);
+    vector<quad_value> values(flowing.size());
+    vector<int> next;
+
+    queued[0] = true;
+    while (!worklist.empty()) {
+        int b = worklist.back();
+        worklist.pop_back();
+        queued[b] = false;
+
+        run_block(b, false, next);
+        bool changed = !reached[b];
+        for (size_t k = 0; k < flowing.size(); k++) {
+            values[k] = current[flowing[k]];
+            if (!changed && !same_value(values[k], exit_values[b][k])) {
+                changed = true;
+            }
+        }
+        reached[b] = true;
+        exit_values[b] = values;
+
+        for (size_t n = 0; n < next.size(); n++) {
+            int s = next[n];
+            bool new_edge = true;
+            for (size_t p = 0; p < reached_from[s].size(); p++) {
+                if (reached_from[s][p] == b) {
+                    new_edge = false;
+                }
+            }
+            if (new_edge) {
+                reached_from[s].push_back(b);
+            }
+            if ((new_edge || changed) && !queued[s]) {
+                queued[s] = true;
+                worklist.push_back(s);
+            }
+        }
+    }
+}
+
+
+void constant_propagation::rewrite()
+{
+    vector<int> next;
+    for (size_t b = 0; b < graph.blocks.size(); b++) {
+        if (reached[b]) {
+            run_block(b, true, next);
+        } else {
+            graph.blocks[b].quads.assign(graph.blocks[b].quads.size(), NULL);
+        }
+    }
+}
+
+
+/* Propagate constants, and clean up after it: the quads that computed
+   what is now loaded are mostly left unused. */
+void quad_optimizer::propagate_constants()
+{
+    constant_propagation propagation(graph);
+    propagation.solve();
+    propagation.rewrite();
+    remove_dead_quads();
+}
+
+
+
+/*** Local value numbering. ***/
+
+/* The quads whose result only depends on their operation and operands,
+   which are the key of the value. Array elements are included, since
+   stores and calls are seen in a basic block. */
+static bool is_pure(quad_op_type op)
+{
+    switch (op) {
+    case q_rstore:
+    case q_istore:
+    case q_rassign:
+    case q_iassign:
+    case q_param:
+    case q_call:
+    case q_rreturn:
+    case q_ireturn:
+    case q_jmp:
+    case q_jmpf:
+    case q_labl:
+    case q_nop:
+        return false;
+    default:
+        return true;
+    }
+}
+
+static bool is_commutative(quad_op_type op)
+{
+    switch (op) {
+    case q_rplus:
+    case q_iplus:
+    case q_ior:
+    case q_iand:
+    case q_rmult:
+    case q_imult:
+    case q_req:
+    case q_ieq:
+    case q_rne:
+    case q_ine:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool reads_array(quad_op_type op)
+{
+    return op == q_rrindex || op == q_irindex;
+}
+
+/* What a pure quad computes: its operation and its two first operands,
+   which for a load is the value loaded. */
+struct value_key
+{
+    quad_op_type op;
+    long         a;
+    long         b;
+
+    bool operator<(const value_key &other) const
+    {
+        if (op != other.op) {
+            return op < other.op;
+        }
+        if (a != other.a) {
+            return a < other.a;
+        }
+        return b < other.b;
+    }
+};
+
+
+/* True if an operand of a value may be changed by assigning a variable,
+   or by calling a procedure declared on a level. Temporaries are never
+   assigned again, and constants never change. */
+static bool is_changed(long operand, int level, sym_index assigned)
+{
+    if (operand == NULL_SYM) {
+        return false;
+    }
+    if (operand == assigned) {
+        return true;
+    }
+    if (level < 0 || sym_tab->is_temp(operand)) {
+        return false;
+    }
+    sym_type tag = sym_tab->get_symbol_tag(operand);
+    return (tag == SYM_VAR || tag == SYM_PARAM) &&
+        sym_tab->get_symbol_level(operand) <= level;
+}
+
+/* Forget the values computed from what a quad changes, and the variables
+   whose values were held in temporaries. For a call, level is the level
+   of the procedure called, and -1 otherwise. Array elements are forgotten
+   by stores and calls. */
+static void forget_values(map<value_key, sym_index> &values,
+                          unordered_map<sym_index, sym_index> &holders,
+                          bool arrays, int level, sym_index assigned)
+{
+    for (map<value_key, sym_index>::iterator it = values.begin();
+         it != values.end(); ) {
+        const value_key &key = it->first;
+        bool loaded = key.op == q_iload || key.op == q_rload;
+        if ((arrays && reads_array(key.op)) ||
+            (!loaded && (is_changed(key.a, level, assigned) ||
+                         is_changed(key.b, level, assigned)))) {
+            it = values.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (unordered_map<sym_index, sym_index>::iterator it = holders.begin();
+         it != holders.end(); ) {
+        if (is_changed(it->first, level, assigned)) {
+            it = holders.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+
+/* Each basic block is gone through from the top, keeping the temporary
+   that holds each value computed so far, and the temporary that holds the
+   value of each variable assigned from one. Temporaries are only assigned
+   once, so they go on holding their values. A quad whose value is held
+   already is turned into a copy of it, and since the reads that follow
+   read the holder instead, the copy is mostly left unused. */
+void quad_optimizer::eliminate_common_subexpressions()
+{
+    map<value_key, sym_index> values;
+    unordered_map<sym_index, sym_index> holders;
+    sym_index *operands[2];
+
+    for (size_t b = 0; b < graph.blocks.size(); b++) {
+        values.clear();
+        holders.clear();
+        vector<quadruple *> &quads = graph.blocks[b].quads;
+        for (size_t i = 0; i < quads.size(); i++) {
+            quadruple *q = quads[i];
+
+            int nr_operands = flow_graph::used_operands(q, operands);
+            for (int k = 0; k < nr_operands; k++) {
+                unordered_map<sym_index, sym_index>::iterator it =
+                    holders.find(*operands[k]);
+                if (it != holders.end()) {
+                    *operands[k] = it->second;
+                }
+            }
+            q->int1 = q->sym1;
+            q->int2 = q->sym2;
+            q->int3 = q->sym3;
+
+            // Forget what may have been changed: an assigned variable,
+            // array elements by a store, and by a call also the variables
+            // the procedure can see.
+            int level = -1;
+            if (q->op_code == q_call) {
+                level = sym_tab->get_symbol_level(q->sym1);
+            }
+            sym_index assigned = flow_graph::defined_symbol(q);
+            if (assigned != NULL_SYM && sym_tab->is_temp(assigned)) {
+                assigned = NULL_SYM;
+            }
+            bool stored = q->op_code == q_istore || q->op_code == q_rstore;
+            if (q->op_code == q_call || stored || assigned != NULL_SYM) {
+                forget_values(values, holders, q->op_code == q_call || stored,
+                              level, assigned);
+            }
+
+            if (assigned != NULL_SYM) {
+                if ((q->op_code == q_iassign || q->op_code == q_rassign) &&
+                    sym_tab->is_temp(q->sym1)) {
+                    holders[assigned] = q->sym1;
+                }
+                continue;
+            }
+            if (!is_pure(q->op_code)) {
+                continue;
+            }
+
+            value_key key = { q->op_code, q->sym1, q->sym2 };
+            if (is_commutative(key.op) && key.a > key.b) {
+                swap(key.a, key.b);
+            }
+            map<value_key, sym_index>::iterator found = values.find(key);
+            if (found == values.end()) {
+                values[key] = q->sym3;
+                continue;
+            }
+
+            holders[q->sym3] = found->second;
+            if (sym_tab->get_symbol_type(q->sym3) == real_type) {
+                q->op_code = q_rassign;
+            } else {
+                q->op_code = q_iassign;
+            }
+            q->int1 = q->sym1 = found->second;
+            q->int2 = q->sym2 = NULL_SYM;
+        }
+    }
+
+    remove_dead_quads();
+}
+
+
+/*** Removing dead quads. ***/
+
+/* The quads are looked at in order, across the blocks, since removing a
+   jump or a label joins blocks. Quads with side effects, calls and stores,
+   are kept even if their results are not used. */
+void quad_optimizer::remove_dead_quads()
+{
+    vector<quadruple **> quads;
+    for (size_t b = 0; b < graph.blocks.size(); b++) {
+        for (size_t i = 0; i < graph.blocks[b].quads.size(); i++) {
+            if (graph.blocks[b].quads[i] != NULL) {
+                quads.push_back(&graph.blocks[b].quads[i]);
+            }
+        }
+    }
+
+    // A jump to one of the labels right after it.
+    for (size_t i = 0; i < quads.size(); i++) {
+        quadruple *q = *quads[i];
+        if (q->op_code != q_jmp && q->op_code != q_jmpf) {
+            continue;
+        }
+        for (size_t j = i + 1; j < quads.size() && *quads[j] != NULL &&
+                 (*quads[j])->op_code == q_labl; j++) {
+            if ((*quads[j])->int1 == q->int1) {
+                *quads[i] = NULL;
+                break;
+            }
+        }
+    }
+
+    // Labels that are not jumped to.
+    vector<long> targets;
+    for (size_t i = 0; i < quads.size(); i++) {
+        quadruple *q = *quads[i];
+        if (q != NULL && (q->op_code == q_jmp || q->op_code == q_jmpf ||
+                          q->op_code == q_ireturn ||
+                          q->op_code == q_rreturn)) {
+            targets.push_back(q->int1);
+        }
+    }
+    sort(targets.begin(), targets.end());
+    for (size_t i = 0; i < quads.size(); i++) {
+        quadruple *q = *quads[i];
+        if (q != NULL && q->op_code == q_labl && q->int1 != graph.last_label &&
+            !binary_search(targets.begin(), targets.end(), q->int1)) {
+            *quads[i] = NULL;
+        }
+    }
+
+    // Temporaries that are not read. Going backwards, the quads that
+    // computed the operands of a removed quad are seen after it.
+    vector<int> reads(graph.variables.size(), 0);
+    sym_index uses[2];
+    for (size_t i = 0; i < quads.size(); i++) {
+        if (*quads[i] != NULL) {
+            int nr_uses = flow_graph::used_symbols(*quads[i], uses);
+            for (int u = 0; u < nr_uses; u++) {
+                int v = graph.variable_number(uses[u]);
+                if (v >= 0) {
+                    reads[v]++;
+                }
+            }
+        }
+    }
+    for (size_t i = quads.size(); i > 0; i--) {
+        quadruple *q = *quads[i - 1];
+        if (q == NULL || q->op_code == q_call) {
+            continue;
+        }
+        sym_index sym_p = flow_graph::defined_symbol(q);
+        if (sym_p == NULL_SYM || !sym_tab->is_temp(sym_p) ||
+            reads[graph.variable_number(sym_p)] > 0) {
+            continue;
+        }
+        int nr_uses = flow_graph::used_symbols(q, uses);
+        for (int u = 0; u < nr_uses; u++) {
+            int v = graph.variable_number(uses[u]);
+            if (v >= 0) {
+                reads[v]--;
+            }
+        }
+        *quads[i - 1] = NULL;
+    }
+
+    graph = flow_graph(graph.get_quads());
+}
@@ -0,0 +1,54 @@
+#ifndef __QUADOPT_HH__
+#define __QUADOPT_HH__
+
+#include "flowgraph.hh"
+
+
+/*** This class optimizes the quads of a block of the program, after they
+     have been generated and before assembler code is generated from them.
+     It works on a flow graph of the quads, see flowgraph.hh. An optimizer
+     is made for one quad list, so that blocks can be optimized on several
+     threads at once. ***/
+
+
+class quad_optimizer
+{
+private:
+    flow_graph graph;
+
+    // Remove jumps to the very next quad, quads that assign temporaries
+    // nobody reads, and labels nobody jumps to, and make a new flow graph
+    // of the quads that are left.
+    void remove_dead_quads();
+
+public:
+    //! Makes an optimizer for the quads of a block.
+    quad_optimizer(quad_list *);
+
+    /*! \brief Propagates constants through variables and temporaries.
+
+    A quad whose result is known at compile time is replaced by a load of
+    that value. The values are followed along the edges of the flow graph
+    that control can take, so a conditional jump on a known condition is
+    replaced by a jump or removed, and the quads that can not be reached
+    are dropped.
+    */
+    void propagate_constants();
+
+    /*! \brief Reuses values already computed in a basic block.
+
+    A quad that computes the same operation on the same values as an
+    earlier quad of its basic block copies the earlier result instead, and
+    reads of a variable that was assigned from a temporary read the
+    temporary. Values are forgotten when the variables they were computed
+    from are assigned, array elements when an array is stored to, and both
+    when a procedure or function is called.
+    */
+    void eliminate_common_subexpressions();
+
+    //! Returns the optimized quads.
+    quad_list *get_quads();
+};
+
+
+#endif
@@ -1,15 +1,14 @@
 #include <iostream>
 #include <iomanip>
 #include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
 #include "symtab.hh"
 #include "ast.hh"
 #include "quads.hh"
+#include "visitor.hh"
 using namespace std;
 
-/* This little #define is only here to suppress compiler warnings for methods
-   not using the quad_list given to it as a parameter. */
-#define USE_Q { quad_list *foo = &q; foo = foo; }
-
 
 /* Constructors for quadruples. The order of assigning the member fields might
    looks strange, but it's arranged in the same order as they are declared
@@ -95,40 +94,159 @@ quad_list &quad_list::operator+=(quadruple *q)
 }
 
 
+/* Write a label, telling a label_buffer written to where it went. The
+   field width applies to the label, so it is looked at before it is
+   used up. */
+ostream &operator<<(ostream &o, const label_ref &ref)
+{
+    label_buffer *buffer = dynamic_cast<label_buffer *>(o.rdbuf());
+    if (buffer != NULL) {
+        buffer->add_label(o);
+    }
+    return o << ref.label;
+}
+
+
+/* Note where the next label written by a stream will be, and the field it
+   will be padded out to. */
+void label_buffer::add_label(ostream &o)
+{
+    label_field field;
+    field.pos = o.tellp();
+    field.width = o.width();
+    field.left = (o.flags() & ios::adjustfield) == ios::left;
+    labels.push_back(field);
+}
+
+
+/* Write the text with each label shifted. A label's field is as wide as
+   the label or the width it was padded out to, whichever is wider, and
+   the shifted label is padded out the same way. */
+void label_buffer::write_to(ostream &o, long shift)
+{
+    string text = str();
+    const char *start = text.c_str();
+    size_t done = 0;
+
+    for (size_t i = 0; i < labels.size(); i++) {
+        size_t pos = labels[i].pos;
+        char *stop;
+        long label = strtol(start + pos, &stop, 10);
+        size_t end = max((size_t) (stop - start),
+                         pos + (size_t) labels[i].width);
+
+        o.write(start + done, pos - done);
+        ios::fmtflags flags = o.flags();
+        o.setf(labels[i].left ? ios::left : ios::right, ios::adjustfield);
+        o << setw(labels[i].width) << label + shift;
+        o.flags(flags);
+        done = end;
+    }
+    o.write(start + done, text.size() - done);
+
+    str("");
+    labels.clear();
+}
+
+
 
 /**************************************************************
  *** THE AST NODE METHODS FOR GENERATING QUADS FOLLOW HERE. ***
  **************************************************************/
 
+/* Quad generation is a pass over the AST, see visitor.hh. visit() generates
+   the quads for a node and its children, adding them to the quad list the
+   generator was made for. The return value is an index to the temporary
+   variable in which will be stored the result the node will generate, in
+   one form or another. For nodes that don't return a useful result,
+   NULL_SYM is returned. It is only used by do_quads(), so it is declared
+   here rather than in quads.hh. */
+class quad_generator : public ast_visitor<quad_generator, sym_index>
+{
+private:
+    // The list the quads are added to.
+    quad_list &q;
+
+    sym_index do_binaryoperation(quad_op_type, quad_op_type,
+                                 ast_binaryoperation *);
+    sym_index do_binaryrelation(quad_op_type, quad_op_type,
+                                ast_binaryrelation *);
+
+public:
+    quad_generator(quad_list &);
+
+    void generate_assignment(ast_lvalue *, sym_index);
+    void generate_parameter_list(ast_expr_list *, parameter_symbol *, int *);
+    void generate_quads_and_jump(ast_elsif *, int);
+    void generate_quads_and_jump(ast_elsif_list *, int);
+
+    sym_index visit_node(ast_node *);
+    sym_index visit_expr_list(ast_expr_list *);
+    sym_index visit_elsif_list(ast_elsif_list *);
+    sym_index visit_elsif(ast_elsif *);
+    sym_index visit_id(ast_id *);
+    sym_index visit_integer(ast_integer *);
+    sym_index visit_real(ast_real *);
+    sym_index visit_not(ast_not *);
+    sym_index visit_uminus(ast_uminus *);
+    sym_index visit_cast(ast_cast *);
+    sym_index visit_add(ast_add *);
+    sym_index visit_sub(ast_sub *);
+    sym_index visit_mult(ast_mult *);
+    sym_index visit_divide(ast_divide *);
+    sym_index visit_idiv(ast_idiv *);
+    sym_index visit_mod(ast_mod *);
+    sym_index visit_or(ast_or *);
+    sym_index visit_and(ast_and *);
+    sym_index visit_equal(ast_equal *);
+    sym_index visit_notequal(ast_notequal *);
+    sym_index visit_lessthan(ast_lessthan *);
+    sym_index visit_greaterthan(ast_greaterthan *);
+    sym_index visit_assign(ast_assign *);
+    sym_index visit_procedurecall(ast_procedurecall *);
+    sym_index visit_functioncall(ast_functioncall *);
+    sym_index visit_while(ast_while *);
+    sym_index visit_if(ast_if *);
+    sym_index visit_return(ast_return *);
+    sym_index visit_indexed(ast_indexed *);
+    sym_index visit_stmt_list(ast_stmt_list *);
+    sym_index visit_procedurehead(ast_procedurehead *);
+    sym_index visit_functionhead(ast_functionhead *);
+};
+
+
+quad_generator::quad_generator(quad_list &ql) :
+    q(ql)
+{
+}
+
+
 /* Methods for the abstract AST classes. Calling these methods is an error,
    which causes the compiler to abort. */
-sym_index ast_expr_list::generate_quads(quad_list &q)
+sym_index quad_generator::visit_node(ast_node *node)
 {
-    USE_Q;
+    fatal("Trying to generate quads for an abstract or unknown AST node.");
+    return NULL_SYM;
+}
 
+sym_index quad_generator::visit_expr_list(ast_expr_list *node)
+{
     fatal("Trying to call generate_quads for ast_expr_list. Try 'generate_parameter_list' instead.");
     return NULL_SYM;
 }
 
-sym_index ast_elsif_list::generate_quads(quad_list &q)
+sym_index quad_generator::visit_elsif_list(ast_elsif_list *node)
 {
-    USE_Q;
-
     fatal("Trying to call generate_quads for ast_elsif_list. Try 'generate_quads_and_jump' instead.");
     return NULL_SYM;
 }
 
 
 
-/* Here come the concrete classes. First the leaf nodes. Note that the
-   return value of all these quads is an index to the temporary variable in
-   which will be stored the the result the node will generate,
-   in one form or another. For nodes that don't return a useful result,
-   NULL_SYM is returned. */
+/* Here come the concrete classes. First the leaf nodes. */
 
-sym_index ast_elsif::generate_quads(quad_list &q)
+sym_index quad_generator::visit_elsif(ast_elsif *node)
 {
-    USE_Q;
     /* Your code here */
 
     fatal("Trying to call generate_quads for ast_elsif. Try 'generate_quads_and_jump' instead.");
@@ -136,30 +254,27 @@ sym_index ast_elsif::generate_quads(quad_list &q)
 }
 
 
-sym_index ast_id::generate_quads(quad_list &q)
+sym_index quad_generator::visit_id(ast_id *node)
 {
-    USE_Q;
     /* Your code here */
-    return sym_p;
+    return node->sym_p;
 }
 
 
-sym_index ast_integer::generate_quads(quad_list &q)
+sym_index quad_generator::visit_integer(ast_integer *node)
 {
-    USE_Q;
     /* Your code here */
     sym_index pos = sym_tab->gen_temp_var(integer_type);
-    q += new quadruple(q_iload, value, NULL_SYM, pos);
+    q += new quadruple(q_iload, node->value, NULL_SYM, pos);
     return pos;
 }
 
 
-sym_index ast_real::generate_quads(quad_list &q)
+sym_index quad_generator::visit_real(ast_real *node)
 {
-    USE_Q;
     /* Your code here */
     sym_index pos = sym_tab->gen_temp_var(real_type);
-    q += new quadruple(q_rload, sym_tab->ieee(value), NULL_SYM, pos);
+    q += new quadruple(q_rload, sym_tab->ieee(node->value), NULL_SYM, pos);
     return pos;
 }
 
@@ -168,33 +283,31 @@ sym_index ast_real::generate_quads(quad_list &q)
 
 
 /* These three following methods are extremely similar, and we could have
-   written a static do_unary function above to handle them. To be able to
+   written a do_unary method below to handle them. To be able to
    do so, we'd have to pass on more arguments than we are to the two
-   do_binary* functions above. Why? */
+   do_binary* methods below. Why? */
 
-sym_index ast_not::generate_quads(quad_list &q)
+sym_index quad_generator::visit_not(ast_not *node)
 {
-    USE_Q;
     /* Your code here */
-    sym_index expr_pos = expr->generate_quads(q);
+    sym_index expr_pos = visit(node->expr);
     sym_index pos = sym_tab->gen_temp_var(integer_type);
     q += new quadruple(q_inot, expr_pos, NULL_SYM, pos);
     return pos;
 }
 
 
-sym_index ast_uminus::generate_quads(quad_list &q)
+sym_index quad_generator::visit_uminus(ast_uminus *node)
 {
-    USE_Q;
     /* Your code here */
-    sym_index expr_pos = expr->generate_quads(q);
-    if (type == integer_type)
+    sym_index expr_pos = visit(node->expr);
+    if (node->type == integer_type)
     {
         sym_index pos = sym_tab->gen_temp_var(integer_type);
         q += new quadruple(q_iuminus, expr_pos, NULL_SYM, pos);
         return pos;
     }
-    if (type == real_type)
+    if (node->type == real_type)
     {
         sym_index pos = sym_tab->gen_temp_var(real_type);
         q += new quadruple(q_ruminus, expr_pos, NULL_SYM, pos);
@@ -204,20 +317,19 @@ sym_index ast_uminus::generate_quads(quad_list &q)
 }
 
 
-sym_index ast_cast::generate_quads(quad_list &q)
+sym_index quad_generator::visit_cast(ast_cast *node)
 {
-    USE_Q;
     /* Your code here */
-    sym_index expr_pos = expr->generate_quads(q);
+    sym_index expr_pos = visit(node->expr);
     sym_index pos = sym_tab->gen_temp_var(real_type);
     q += new quadruple(q_itor, expr_pos, NULL_SYM, pos);
     return pos;
 }
 
-sym_index do_binaryoperation(quad_list &q, quad_op_type qiop, quad_op_type qrop, ast_binaryoperation* op)
+sym_index quad_generator::do_binaryoperation(quad_op_type qiop, quad_op_type qrop, ast_binaryoperation* op)
 {
-    sym_index left_expr_pos = op->left->generate_quads(q);
-    sym_index right_expr_pos = op->right->generate_quads(q);
+    sym_index left_expr_pos = visit(op->left);
+    sym_index right_expr_pos = visit(op->right);
 
     if (op->left->type == integer_type && op->right->type == integer_type)
     {
@@ -235,65 +347,57 @@ sym_index do_binaryoperation(quad_list &q, quad_op_type qiop, quad_op_type qrop,
 }
 
 
-sym_index ast_add::generate_quads(quad_list &q)
+sym_index quad_generator::visit_add(ast_add *node)
 {
-    USE_Q;
-    return do_binaryoperation(q, q_iplus, q_rplus, this);
+    return do_binaryoperation(q_iplus, q_rplus, node);
 }
 
-sym_index ast_sub::generate_quads(quad_list &q)
+sym_index quad_generator::visit_sub(ast_sub *node)
 {
-    USE_Q;
     /* Your code here */
-    return do_binaryoperation(q, q_iminus, q_rminus, this);
+    return do_binaryoperation(q_iminus, q_rminus, node);
 }
 
-sym_index ast_mult::generate_quads(quad_list &q)
+sym_index quad_generator::visit_mult(ast_mult *node)
 {
-    USE_Q;
     /* Your code here */
-    return do_binaryoperation(q, q_imult, q_rmult, this);
+    return do_binaryoperation(q_imult, q_rmult, node);
 }
 
-sym_index ast_divide::generate_quads(quad_list &q)
+sym_index quad_generator::visit_divide(ast_divide *node)
 {
-    USE_Q;
     /* Your code here */
-    return do_binaryoperation(q, q_rdivide, q_rdivide, this);
+    return do_binaryoperation(q_rdivide, q_rdivide, node);
 }
 
-sym_index ast_idiv::generate_quads(quad_list &q)
+sym_index quad_generator::visit_idiv(ast_idiv *node)
 {
-    USE_Q;
     /* Your code here */
-    return do_binaryoperation(q, q_idivide, q_idivide, this);
+    return do_binaryoperation(q_idivide, q_idivide, node);
 }
 
-sym_index ast_mod::generate_quads(quad_list &q)
+sym_index quad_generator::visit_mod(ast_mod *node)
 {
-    USE_Q;
     /* Your code here */
-    return do_binaryoperation(q, q_imod, q_imod, this);
+    return do_binaryoperation(q_imod, q_imod, node);
 }
 
-sym_index ast_or::generate_quads(quad_list &q)
+sym_index quad_generator::visit_or(ast_or *node)
 {
-    USE_Q;
     /* Your code here */
-    return do_binaryoperation(q, q_ior, q_ior, this);
+    return do_binaryoperation(q_ior, q_ior, node);
 }
 
-sym_index ast_and::generate_quads(quad_list &q)
+sym_index quad_generator::visit_and(ast_and *node)
 {
-    USE_Q;
     /* Your code here */
-    return do_binaryoperation(q, q_iand, q_iand, this);
+    return do_binaryoperation(q_iand, q_iand, node);
 }
 
-sym_index do_binaryrelation(quad_list &q, quad_op_type qiop, quad_op_type qrop, ast_binaryrelation* op)
+sym_index quad_generator::do_binaryrelation(quad_op_type qiop, quad_op_type qrop, ast_binaryrelation* op)
 {
-    sym_index left_expr_pos = op->left->generate_quads(q);
-    sym_index right_expr_pos = op->right->generate_quads(q);
+    sym_index left_expr_pos = visit(op->left);
+    sym_index right_expr_pos = visit(op->right);
 
     sym_index pos = sym_tab->gen_temp_var(integer_type);
     if (op->left->type == integer_type && op->right->type == integer_type)
@@ -309,129 +413,120 @@ sym_index do_binaryrelation(quad_list &q, quad_op_type qiop, quad_op_type qrop,
     return NULL_SYM;
 }
 
-sym_index ast_equal::generate_quads(quad_list &q)
+sym_index quad_generator::visit_equal(ast_equal *node)
 {
-    USE_Q;
     /* Your code here */
-    return do_binaryrelation(q, q_ieq, q_req, this);
+    return do_binaryrelation(q_ieq, q_req, node);
 }
 
-sym_index ast_notequal::generate_quads(quad_list &q)
+sym_index quad_generator::visit_notequal(ast_notequal *node)
 {
-    USE_Q;
     /* Your code here */
-    return do_binaryrelation(q, q_ine, q_rne, this);
+    return do_binaryrelation(q_ine, q_rne, node);
 }
 
-sym_index ast_lessthan::generate_quads(quad_list &q)
+sym_index quad_generator::visit_lessthan(ast_lessthan *node)
 {
-    USE_Q;
     /* Your code here */
-    return do_binaryrelation(q, q_ilt, q_rlt, this);
+    return do_binaryrelation(q_ilt, q_rlt, node);
 }
 
-sym_index ast_greaterthan::generate_quads(quad_list &q)
+sym_index quad_generator::visit_greaterthan(ast_greaterthan *node)
 {
-    USE_Q;
     /* Your code here */
-    return do_binaryrelation(q, q_igt, q_rgt, this);
+    return do_binaryrelation(q_igt, q_rgt, node);
 }
 
 
 
 
-/* Since an lvalue can be either an id or an array reference, we can't solve
-   this the usual way since there's no instanceof operator in C++ to find out
-   which class an object belongs to. So we define the method
-   generate_assignment() in both ast_id and ast_indexed, and let the virtual
-   mechanism figure out which one to call. */
-void ast_id::generate_assignment(quad_list &q, sym_index rhs)
+/* Since an lvalue can be either an id or an array reference, we look at
+   the tag of the node to find out which one it is. */
+void quad_generator::generate_assignment(ast_lvalue *lhs, sym_index rhs)
 {
-    if (type == integer_type) {
-        q += new quadruple(q_iassign, rhs, NULL_SYM, sym_p);
-    } else if (type == real_type) {
-        q += new quadruple(q_rassign, rhs, NULL_SYM, sym_p);
-    } else {
-        fatal("Illegal type in ast_id::generate_assignment()");
+    if (lhs->tag == AST_ID) {
+        ast_id *id = static_cast<ast_id *>(lhs);
+        if (id->type == integer_type) {
+            q += new quadruple(q_iassign, rhs, NULL_SYM, id->sym_p);
+        } else if (id->type == real_type) {
+            q += new quadruple(q_rassign, rhs, NULL_SYM, id->sym_p);
+        } else {
+            fatal("Illegal type in generate_assignment() for ast_id");
+        }
+        return;
     }
-}
 
-void ast_indexed::generate_assignment(quad_list &q, sym_index rhs)
-{
-    sym_index index_pos = index->generate_quads(q);
+    ast_indexed *indexed = static_cast<ast_indexed *>(lhs);
+    sym_index index_pos = visit(indexed->index);
     sym_index address = sym_tab->gen_temp_var(integer_type);
 
-    q += new quadruple(q_lindex, id->sym_p, index_pos, address);
+    q += new quadruple(q_lindex, indexed->id->sym_p, index_pos, address);
 
-    if (type == integer_type) {
+    if (indexed->type == integer_type) {
         q += new quadruple(q_istore, rhs, NULL_SYM, address);
-    } else if (type == real_type) {
+    } else if (indexed->type == real_type) {
         q += new quadruple(q_rstore, rhs, NULL_SYM, address);
     } else {
-        fatal("Illegal type in ast_indexed::generate_assignment()");
+        fatal("Illegal type in generate_assignment() for ast_indexed");
     }
 }
 
 
 /* Statements of various kinds. */
-sym_index ast_assign::generate_quads(quad_list &q)
+sym_index quad_generator::visit_assign(ast_assign *node)
 {
-    sym_index right_pos = rhs->generate_quads(q);
-    lhs->generate_assignment(q, right_pos);
+    sym_index right_pos = visit(node->rhs);
+    generate_assignment(node->lhs, right_pos);
     return NULL_SYM;
 }
 
 
 /* Parameters need to be treated specially as well. What we do here is
-   to recurse from the last parameter forward. In this process we use the
-   nr_param pointer (which is incremented by one for each recursive call)
+   to go from the last parameter forward. In this process we use the
+   nr_param pointer (which is incremented by one for each parameter)
    to get the total number of parameters so we can generate a correct q_call
    quad for the new function/procedure that the parameters belong to.
     */
-void ast_expr_list::generate_parameter_list(quad_list &q,
+void quad_generator::generate_parameter_list(ast_expr_list *node,
         parameter_symbol *last_param,
         int *nr_params)
 {
-    USE_Q;
     /* Your code here */
-    if (last_expr != NULL)
-    {
-        (*nr_params)++;
-        q += new quadruple(q_param, last_expr->generate_quads(q), NULL_SYM, NULL_SYM);
-    }
-    if (preceding != NULL)
+    for (int i = node->exprs.size() - 1; i >= 0; i--)
     {
-        preceding->generate_parameter_list(q, NULL, nr_params);
+        if (node->exprs[i] != NULL)
+        {
+            (*nr_params)++;
+            q += new quadruple(q_param, visit(node->exprs[i]), NULL_SYM, NULL_SYM);
+        }
     }
 }
 
 
 /* Generate quads for a procedure call. */
-sym_index ast_procedurecall::generate_quads(quad_list &q)
+sym_index quad_generator::visit_procedurecall(ast_procedurecall *node)
 {
-    USE_Q;
     /* Your code here */
     int nr_params = 0;
-    if (parameter_list != NULL)
+    if (node->parameter_list != NULL)
     {
-        parameter_list->generate_parameter_list(q, NULL, &nr_params);
+        generate_parameter_list(node->parameter_list, NULL, &nr_params);
     }
-    q += new quadruple(q_call, id->generate_quads(q), nr_params, NULL_SYM);
+    q += new quadruple(q_call, visit(node->id), nr_params, NULL_SYM);
     return NULL_SYM;
 }
 
 
 /* Generate quads for a function call. */
-sym_index ast_functioncall::generate_quads(quad_list &q)
+sym_index quad_generator::visit_functioncall(ast_functioncall *node)
 {
-    USE_Q;
     /* Your code here */
     int nr_params = 0;
-    sym_index id_pos = id->generate_quads(q);
-    sym_index pos = sym_tab->gen_temp_var(type);
-    if (parameter_list != NULL)
+    sym_index id_pos = visit(node->id);
+    sym_index pos = sym_tab->gen_temp_var(node->type);
+    if (node->parameter_list != NULL)
     {
-        parameter_list->generate_parameter_list(q, NULL, &nr_params);
+        generate_parameter_list(node->parameter_list, NULL, &nr_params);
     }
     q += new quadruple(q_call, id_pos, nr_params, pos);
     return pos;
@@ -440,7 +535,7 @@ sym_index ast_functioncall::generate_quads(quad_list &q)
 
 /* Generate quads for a while statement.
     */
-sym_index ast_while::generate_quads(quad_list &q)
+sym_index quad_generator::visit_while(ast_while *node)
 {
     // We get two labels for jumps.
     int top = sym_tab->get_next_label();
@@ -453,14 +548,14 @@ sym_index ast_while::generate_quads(quad_list &q)
     // check if the result in the variable stored in 'pos' is 0. If it is,
     // we want to exit the loop, which is done via a conditional jump to the
     // 'body_bottom' label.
-    sym_index pos = condition->generate_quads(q);
+    sym_index pos = visit(node->condition);
     q += new quadruple(q_jmpf, body_bottom, pos, NULL_SYM);
 
     // Generate quads for the body. Following these come an unconditional
     // jump to the 'top' label, ie, run the condition etc again.
-    if (body != NULL)
+    if (node->body != NULL)
     {
-        body->generate_quads(q);
+        visit(node->body);
     }
     q += new quadruple(q_jmp, top,  NULL_SYM, NULL_SYM);
 
@@ -472,19 +567,18 @@ sym_index ast_while::generate_quads(quad_list &q)
 
 
 /* Generate quads for an individual elsif statement, including an ending
-   jump to an end label. See ast_if::generate_quads for more information. */
-void ast_elsif::generate_quads_and_jump(quad_list &q, int bottom_label)
+   jump to an end label. See visit_if for more information. */
+void quad_generator::generate_quads_and_jump(ast_elsif *node, int bottom_label)
 {
-    USE_Q;
     /* Your code here */
     int body_bottom = sym_tab->get_next_label();
-    sym_index pos = condition->generate_quads(q);
+    sym_index pos = visit(node->condition);
     // Jump past the body if condition is not satisfied
     q += new quadruple(q_jmpf, body_bottom, pos, NULL_SYM);
     { // If the condition is satisfied
-        if (body != NULL)
+        if (node->body != NULL)
         {
-            body->generate_quads(q);
+            visit(node->body);
         }
         // EXIT: Jump to end of whole if statement
         q += new quadruple(q_jmp, bottom_label, NULL_SYM, NULL_SYM);
@@ -496,56 +590,53 @@ void ast_elsif::generate_quads_and_jump(quad_list &q, int bottom_label)
 
 
 /* Generate quads (with an ending jump to an end label) for an elsif list.
-   See generate_quads for ast_if for more information. */
-void ast_elsif_list::generate_quads_and_jump(quad_list &q, int bottom_label)
+   See visit_if for more information. */
+void quad_generator::generate_quads_and_jump(ast_elsif_list *node, int bottom_label)
 {
-    USE_Q;
     /* Your code here */
-    if (preceding != NULL)
-    {   
-        preceding->generate_quads_and_jump(q, bottom_label);
-    }
-    if (last_elsif != NULL)
+    for (int i = 0; i < node->elsifs.size(); i++)
     {
-        last_elsif->generate_quads_and_jump(q,bottom_label);
+        if (node->elsifs[i] != NULL)
+        {
+            generate_quads_and_jump(node->elsifs[i], bottom_label);
+        }
     }
     // q += new quadruple(q_jmp, bottom_label, NULL_SYM, NULL_SYM);
 }
 
 
 /* Generate quads for an if statement. */
-sym_index ast_if::generate_quads(quad_list &q)
+sym_index quad_generator::visit_if(ast_if *node)
 {
-    USE_Q;
     /* Your code here */
     int body_bottom = sym_tab->get_next_label();
 
     int bottom;
     
-    sym_index pos = condition->generate_quads(q);
+    sym_index pos = visit(node->condition);
     // Jump past the body if condition is not satisfied
     q += new quadruple(q_jmpf, body_bottom, pos, NULL_SYM);
-    if (body != NULL)
+    if (node->body != NULL)
     {
-        body->generate_quads(q);
+        visit(node->body);
     }
-    if (elsif_list != NULL || else_body != NULL) {
+    if (node->elsif_list != NULL || node->else_body != NULL) {
         bottom = sym_tab->get_next_label();
         q += new quadruple(q_jmp, bottom, NULL_SYM, NULL_SYM);
     }
     q += new quadruple(q_labl, body_bottom, NULL_SYM, NULL_SYM);
 
 
-    if (elsif_list != NULL)
+    if (node->elsif_list != NULL)
     {
-        elsif_list->generate_quads_and_jump(q, bottom);
+        generate_quads_and_jump(node->elsif_list, bottom);
     }
 
-    if (else_body != NULL)
+    if (node->else_body != NULL)
     {
-        else_body->generate_quads(q);
+        visit(node->else_body);
     }
-    if (elsif_list != NULL || else_body != NULL) {
+    if (node->elsif_list != NULL || node->else_body != NULL) {
         q += new quadruple(q_labl, bottom, NULL_SYM, NULL_SYM);
     }
     
@@ -554,22 +645,21 @@ sym_index ast_if::generate_quads(quad_list &q)
 
 
 /* Generate quads for a return statement. */
-sym_index ast_return::generate_quads(quad_list &q)
+sym_index quad_generator::visit_return(ast_return *node)
 {
-    USE_Q;
     /* Your code here */
-    if (value == NULL)
+    if (node->value == NULL)
     {
         q += new quadruple(q_jmp, q.last_label, NULL_SYM, NULL_SYM);
         return NULL_SYM;
     }
 
-    sym_index pos = value->generate_quads(q);
-    if (value->type == integer_type)
+    sym_index pos = visit(node->value);
+    if (node->value->type == integer_type)
     {
         q += new quadruple(q_ireturn, q.last_label, pos, NULL_SYM);
     }
-    else if (value->type == real_type)
+    else if (node->value->type == real_type)
     {
         q += new quadruple(q_rreturn, q.last_label, pos, NULL_SYM);
     }
@@ -578,21 +668,20 @@ sym_index ast_return::generate_quads(quad_list &q)
 
 
 /* Generate quads for an array reference. */
-sym_index ast_indexed::generate_quads(quad_list &q)
+sym_index quad_generator::visit_indexed(ast_indexed *node)
 {
-    USE_Q;
     /* Your code here */
-    sym_index index_pos = index->generate_quads(q);
-    if (id->type == integer_type)
+    sym_index index_pos = visit(node->index);
+    if (node->id->type == integer_type)
     {
         sym_index pos = sym_tab->gen_temp_var(integer_type);
-        q += new quadruple(q_irindex, id->generate_quads(q), index_pos, pos);
+        q += new quadruple(q_irindex, visit(node->id), index_pos, pos);
         return pos;
     }
-    if (id->type == real_type)
+    if (node->id->type == real_type)
     {
         sym_index pos = sym_tab->gen_temp_var(real_type);
-        q += new quadruple(q_rrindex, id->generate_quads(q), index_pos, pos);
+        q += new quadruple(q_rrindex, visit(node->id), index_pos, pos);
         return pos;
     }
     return NULL_SYM;
@@ -601,32 +690,24 @@ sym_index ast_indexed::generate_quads(quad_list &q)
 
 /* Generate quads for a list of statements. Note that this is not necessarily
    the most efficient way to do it... Why not? */
-sym_index ast_stmt_list::generate_quads(quad_list &q)
+sym_index quad_generator::visit_stmt_list(ast_stmt_list *node)
 {
-    if (preceding != NULL) {
-        preceding->generate_quads(q);
-    }
-    if (last_stmt != NULL) {
-        last_stmt->generate_quads(q);
+    for (int i = 0; i < node->stmts.size(); i++) {
+        visit(node->stmts[i]);
     }
     return NULL_SYM;
 }
 
 
 /* These classes won't actually appear in the part of the AST we generate
-   code for, but since we're using abstract virtual methods, these methods
-   need to be defined. */
-sym_index ast_procedurehead::generate_quads(quad_list &q)
+   code for. */
+sym_index quad_generator::visit_procedurehead(ast_procedurehead *node)
 {
-    USE_Q;
-
     return NULL_SYM;
 }
 
-sym_index ast_functionhead::generate_quads(quad_list &q)
+sym_index quad_generator::visit_functionhead(ast_functionhead *node)
 {
-    USE_Q;
-
     return NULL_SYM;
 }
 
@@ -640,7 +721,7 @@ quad_list *ast_procedurehead::do_quads(ast_stmt_list *s)
     quad_list *q = new quad_list(last_label);
 
     if (s != NULL) {
-        s->generate_quads(*q);
+        quad_generator(*q).visit(s);
     }
 
     (*q) += new quadruple(q_labl, last_label, NULL_SYM, NULL_SYM);
@@ -654,7 +735,7 @@ quad_list *ast_functionhead::do_quads(ast_stmt_list *s)
     quad_list *q = new quad_list(last_label);
 
     if (s != NULL) {
-        s->generate_quads(*q);
+        quad_generator(*q).visit(s);
     }
 
     (*q) += new quadruple(q_labl, last_label, NULL_SYM, NULL_SYM);
@@ -677,233 +758,233 @@ void quadruple::print(ostream &o)
         o << setw(11) << "q_rload"
           << setw(11) << int1
           << setw(11) << "-"
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym3);
         break;
     case q_iload:
         o << setw(11) << "q_iload"
           << setw(11) << int1
           << setw(11) << "-"
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym3);
         break;
     case q_inot:
         o << setw(11) << "q_inot"
-          << setw(11) << sym_tab->get_symbol(sym1)
+          << setw(11) << sym_ref(sym1)
           << setw(11) << "-"
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym3);
         break;
     case q_ruminus:
         o << setw(11) << "q_ruminus"
-          << setw(11) << sym_tab->get_symbol(sym1)
+          << setw(11) << sym_ref(sym1)
           << setw(11) << "-"
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym3);
         break;
     case q_iuminus:
         o << setw(11) << "q_iuminus"
-          << setw(11) << sym_tab->get_symbol(sym1)
+          << setw(11) << sym_ref(sym1)
           << setw(11) << "-"
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym3);
         break;
     case q_rplus:
         o << setw(11) << "q_rplus"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_iplus:
         o << setw(11) << "q_iplus"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_rminus:
         o << setw(11) << "q_rminus"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_iminus:
         o << setw(11) << "q_iminus"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_ior:
         o << setw(11) << "q_ior"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_iand:
         o << setw(11) << "q_iand"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_rmult:
         o << setw(11) << "q_rmult"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_imult:
         o << setw(11) << "q_imult"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_rdivide:
         o << setw(11) << "q_rdivide"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_idivide:
         o << setw(11) << "q_idivide"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_imod:
         o << setw(11) << "q_imod"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_req:
         o << setw(11) << "q_req"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_ieq:
         o << setw(11) << "q_ieq"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_rne:
         o << setw(11) << "q_rne"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_ine:
         o << setw(11) << "q_ine"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_rlt:
         o << setw(11) << "q_rlt"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_ilt:
         o << setw(11) << "q_ilt"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_rgt:
         o << setw(11) << "q_rgt"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_igt:
         o << setw(11) << "q_igt"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_rstore:
         o << setw(11) << "q_rstore"
-          << setw(11) << sym_tab->get_symbol(sym1)
+          << setw(11) << sym_ref(sym1)
           << setw(11) << "-"
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym3);
         break;
     case q_istore:
         o << setw(11) << "q_istore"
-          << setw(11) << sym_tab->get_symbol(sym1)
+          << setw(11) << sym_ref(sym1)
           << setw(11) << "-"
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym3);
         break;
     case q_rassign:
         o << setw(11) << "q_rassign"
-          << setw(11) << sym_tab->get_symbol(sym1)
+          << setw(11) << sym_ref(sym1)
           << setw(11) << "-"
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym3);
         break;
     case q_iassign:
         o << setw(11) << "q_iassign"
-          << setw(11) << sym_tab->get_symbol(sym1)
+          << setw(11) << sym_ref(sym1)
           << setw(11) << "-"
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym3);
         break;
     case q_call:
         o << setw(11) << "q_call"
-          << setw(11) << sym_tab->get_symbol(sym1)
+          << setw(11) << sym_ref(sym1)
           << setw(11) << int2
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym3);
         break;
     case q_rreturn:
         o << setw(11) << "q_rreturn"
-          << setw(11) << int1
-          << setw(11) << sym_tab->get_symbol(sym2)
+          << setw(11) << label_ref(int1)
+          << setw(11) << sym_ref(sym2)
           << setw(11) << "-";
         break;
     case q_ireturn:
         o << setw(11) << "q_ireturn"
-          << setw(11) << int1
-          << setw(11) << sym_tab->get_symbol(sym2)
+          << setw(11) << label_ref(int1)
+          << setw(11) << sym_ref(sym2)
           << setw(11) << "-";
         break;
     case q_lindex:
         o << setw(11) << "q_lindex"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_rrindex:
         o << setw(11) << "q_rrindex"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_irindex:
         o << setw(11) << "q_irindex"
-          << setw(11) << sym_tab->get_symbol(sym1)
-          << setw(11) << sym_tab->get_symbol(sym2)
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym1)
+          << setw(11) << sym_ref(sym2)
+          << setw(11) << sym_ref(sym3);
         break;
     case q_itor:
         o << setw(11) << "q_itor"
-          << setw(11) << sym_tab->get_symbol(sym1)
+          << setw(11) << sym_ref(sym1)
           << setw(11) << "-"
-          << setw(11) << sym_tab->get_symbol(sym3);
+          << setw(11) << sym_ref(sym3);
         break;
     case q_jmp:
         o << setw(11) << "q_jmp"
-          << setw(11) << int1
+          << setw(11) << label_ref(int1)
           << setw(11) << "-"
           << setw(11) << "-";
         break;
     case q_jmpf:
         o << setw(11) << "q_jmpf"
-          << setw(11) << int1
-          << setw(11) << sym_tab->get_symbol(sym2)
+          << setw(11) << label_ref(int1)
+          << setw(11) << sym_ref(sym2)
           << setw(11) << "-";
         break;
     case q_param:
         o << setw(11) << "q_param"
-          << setw(11) << sym_tab->get_symbol(sym1)
+          << setw(11) << sym_ref(sym1)
           << setw(11) << "-"
           << setw(11) << "-";
         break;
     case q_labl:
         o << setw(11) << "q_labl"
-          << setw(11) << int1
+          << setw(11) << label_ref(int1)
           << setw(11) << "-"
           << setw(11) << "-";
         break;
@@ -1,6 +1,9 @@
 #ifndef __QUADS_HH__
 #define __QUADS_HH__
 
+#include <sstream>
+#include <vector>
+
 #include "ast.hh"
 
 /* Credits to David Byers for the design of this class. /Jonas */
@@ -156,4 +159,45 @@ public:
 };
 
 
+
+/* Wraps the number of a label taken with get_next_label() so it can be
+   sent to an outstream. It prints like the number itself, but if the
+   stream writes to a label_buffer, the buffer is told where it went. */
+struct label_ref {
+    long label;
+    explicit label_ref(long l) : label(l) {}
+};
+
+ostream &operator<<(ostream &, const label_ref &);
+
+
+
+/* A string buffer for the printouts or the code of a block compiled on a
+   worker thread. The block's labels are stand-ins from its backend space
+   while they are written, see symbol_table::new_backend_space(), so the
+   buffer keeps track of where each one went. Once the labels of the
+   blocks before it have been taken, write_to() writes the text with the
+   labels renumbered. */
+class label_buffer : public stringbuf
+{
+private:
+    // A label written to the buffer, in a field padded out to width.
+    typedef struct {
+        streamoff  pos;
+        streamsize width;
+        bool       left;     // True if padded on the right.
+    } label_field;
+
+    vector<label_field> labels;
+
+public:
+    // Notes that a label is about to be written by a stream to the buffer.
+    void add_label(ostream &);
+
+    // Writes the text to a stream with shift added to each label, and
+    // empties the buffer.
+    void write_to(ostream &, long shift);
+};
+
+
 #endif
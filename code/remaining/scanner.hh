@@ -14,13 +14,8 @@ typedef union {
     pool_index    pool_p;
 } YYSTYPE;
 
-//! For every token, these fields should be set to the correct position in the source code file.
-typedef struct {
-    int first_line;
-    int first_column;
-    int last_line;
-    int last_column;
-} YYLTYPE;
+//! For every token, this should be set to its location in the source code.
+typedef position_information YYLTYPE;
 
 #define T_EOF   0 // end of file - must be 0 for bison
 #define T_ERROR   258 // invalid token
@@ -1,4 +1,6 @@
+#include <vector>
 #include "semantic.hh"
+#include "optimize.hh"
 
 semantic *type_checker = new semantic();
 
@@ -34,18 +36,25 @@ ostream &operator<<(ostream &oss, sym_type tag)
 static bool has_return = false;
 
 
+/* Constructor. */
+semantic::semantic()
+{
+    folding = false;
+}
+
+
 /* Interface for type checking a block of code represented as an AST node. */
 void semantic::do_typecheck(symbol *env, ast_stmt_list *body)
 {
     // Reset the variable, since we're checking a new block of code.
     has_return = false;
     if (body) {
-        body->type_check();
+        visit(body);
     }
 
     // This is the only case we need this variable for - a function lacking
     // a return statement. All other cases are already handled in
-    // ast_return::type_check(); see below.
+    // visit_return(); see below.
     if (env->tag == SYM_FUNC && !has_return) {
         // Note: We could do this by overloading the do_typecheck() method -
         // one for ast_procedurehead and one for ast_functionhead, but this
@@ -59,40 +68,153 @@ void semantic::do_typecheck(symbol *env, ast_stmt_list *body)
     }
 }
 
-/* Compare formal vs. actual parameters recursively. */
+
+/* Type check a block, folding its constants on the way. The optimizer
+   folds the operands of a node after the type checker is done with the
+   whole block, so a node is folded here once its parent has given it
+   any cast it needs. See fold(). */
+void semantic::do_typecheck_and_fold(symbol *env, ast_stmt_list *body)
+{
+    folding = true;
+    do_typecheck(env, body);
+    folding = false;
+}
+
+
+/* Fold the node in a place in the AST, just as the optimizer would. Its
+   own operands were folded when it was type checked. What is changed is
+   recorded in folds, so that it can be taken back. */
+void semantic::fold(ast_expression *&place)
+{
+    if (!folding) {
+        return;
+    }
+
+    ast_expression *node = place;
+    ast_binaryoperation *op = NULL;
+    ast_expression *left = NULL;
+    ast_expression *right = NULL;
+    if (optimizer->is_binop(node)) {
+        op = static_cast<ast_binaryoperation *>(node);
+        left = op->left;
+        right = op->right;
+    }
+
+    place = optimizer->fold_operation(node);
+
+    // Constant identifiers among the operands may have been replaced.
+    if (op != NULL && op->left != left) {
+        folds.push_back({ &op->left, left });
+    }
+    if (op != NULL && op->right != right) {
+        folds.push_back({ &op->right, right });
+    }
+    if (place != node) {
+        folds.push_back({ &place, node });
+    }
+}
+
+
+/* Parameters that are not type checked, because of an error in the call,
+   are still optimized. That is done at the end of the statement, unless
+   they turn out to be below a cast. */
+void semantic::fold_unchecked(ast_expr_list *actuals, int from)
+{
+    if (!folding || actuals == NULL) {
+        return;
+    }
+
+    for (int i = from; i < actuals->exprs.size(); i++) {
+        if (actuals->exprs[i] != NULL) {
+            folds.push_back({ &actuals->exprs[i], NULL });
+        }
+    }
+}
+
+
+/* Put back what a range of folds changed, latest first, and forget them. */
+void semantic::take_back_folds(size_t from, size_t to)
+{
+    for (size_t i = to; i > from; i--) {
+        if (folds[i - 1].other != NULL) {
+            *folds[i - 1].place = folds[i - 1].other;
+        }
+    }
+    folds.erase(folds.begin() + from, folds.begin() + to);
+}
+
+
+/* Undo a range of folds, latest first, keeping what they changed so that
+   they can be redone in order afterwards. */
+void semantic::swap_folds(size_t from, size_t to, bool undo)
+{
+    for (size_t n = from; n < to; n++) {
+        fold_record &r = folds[undo ? to - 1 - (n - from) : n];
+        if (r.other != NULL) {
+            std::swap(*r.place, r.other);
+        }
+    }
+}
+
+
+/* Optimize the parameters that were left over in the statement just type
+   checked. Its folds are final now. */
+void semantic::finish_folds()
+{
+    for (size_t i = 0; i < folds.size(); i++) {
+        if (folds[i].other == NULL) {
+            *folds[i].place = optimizer->fold_constants(*folds[i].place);
+        }
+    }
+    folds.clear();
+}
+
+/* Compare formal vs. actual parameters. The formals are linked from the
+   last one backwards. The parameters are compared from the first one on,
+   and only if there are as many actual as formal parameters; the first
+   discrepancy is reported. */
 bool semantic::chk_param(ast_id *env,
                          parameter_symbol *formals,
                          ast_expr_list *actuals)
 {
     /* Your code here */
-    if (actuals == NULL && formals == NULL)
-    {
-        return true;
+    int nr_actuals = actuals == NULL ? 0 : actuals->exprs.size();
+    vector<parameter_symbol *> in_order;
+    for (parameter_symbol *p = formals; p != NULL; p = p->preceding) {
+        in_order.push_back(p);
     }
-    if (actuals != NULL && formals != NULL)
+    int nr_formals = in_order.size();
+
+    if (nr_actuals > nr_formals)
     {
-        if (chk_param(env, formals->preceding, actuals->preceding))
-        {
-            if (actuals->last_expr->type_check() != formals->type)
-            {
-                type_error(actuals->pos) << "Type discrepancy between formal and actual parameters." << endl;
-                return false;
-            }
-            return true;
-        }
+        type_error(actuals->pos) << "More actual than formal parameters." << endl;
+        fold_unchecked(actuals, 0);
         return false;
     }
-    if (actuals == NULL)
+    if (nr_actuals < nr_formals)
     {
         type_error(env->pos) << "More formal than actual parameters." << endl;
+        fold_unchecked(actuals, 0);
         return false;
     }
-    if (formals == NULL)
+    for (int i = 0; i < nr_actuals; i++)
     {
-        type_error(actuals->pos) << "More actual than formal parameters." << endl;
-        return false;
+        parameter_symbol *formal = in_order[nr_formals - 1 - i];
+        ast_expression *actual = actuals->exprs[i];
+        if (actual == NULL)
+        {
+            continue;
+        }
+        sym_index actual_type = visit(actual);
+        fold(actuals->exprs[i]);
+        if (actual_type != formal->type)
+        {
+            type_error(actuals->pos) << "Type discrepancy between formal and actual parameters." << endl;
+            fold_unchecked(actuals, i + 1);
+            return false;
+        }
     }
-
+    return true;
 }
 
 /* Check formal vs. actual parameters at procedure/function calls. */
@@ -100,19 +222,20 @@ void semantic::check_parameters(ast_id *call_id,
                                 ast_expr_list *param_list)
 {
     /* Your code here */
-    symbol *sym = sym_tab->get_symbol(call_id->sym_p);
+    sym_type tag = sym_tab->get_symbol_tag(call_id->sym_p);
     parameter_symbol *formals;
-    if (sym->tag == SYM_FUNC)
+    if (tag == SYM_FUNC)
     {
-        formals = sym->get_function_symbol()->last_parameter;
+        formals = sym_tab->get_symbol(call_id->sym_p)->get_function_symbol()->last_parameter;
     }
-    else if (sym->tag == SYM_PROC) 
+    else if (tag == SYM_PROC) 
     {
-        formals = sym->get_procedure_symbol()->last_parameter;
+        formals = sym_tab->get_symbol(call_id->sym_p)->get_procedure_symbol()->last_parameter;
     } 
     else 
     {
-        type_error(call_id->pos) << "Parameters sent to unsupported type: " << sym->tag << endl;
+        type_error(call_id->pos) << "Parameters sent to unsupported type: " << tag << endl;
+        fold_unchecked(param_list, 0);
         return;
     }
 
@@ -121,72 +244,43 @@ void semantic::check_parameters(ast_id *call_id,
 
 
 
-/* We overload this method for the various ast_node subclasses that can
-   appear in the AST. By use of virtual (dynamic) methods, we ensure that
-   the correct method is invoked even if the pointers in the AST refer to
-   one of the abstract classes such as ast_expression or ast_statement. */
-sym_index ast_node::type_check()
+/* The methods of the pass follow, one for each of the ast_node subclasses
+   that can appear in the AST. visit() looks at the tag of a node to call
+   the right one, even if the pointers in the AST refer to one of the
+   abstract classes such as ast_expression or ast_statement. Nodes that
+   have no method here, like the abstract classes, end up in visit_node(). */
+sym_index semantic::visit_node(ast_node *node)
 {
-    fatal("Trying to type check abstract class ast_node.");
-    return void_type;
-}
-
-sym_index ast_statement::type_check()
-{
-    fatal("Trying to type check abstract class ast_statement.");
-    return void_type;
-}
-
-sym_index ast_expression::type_check()
-{
-    fatal("Trying to type check abstract class ast_expression.");
-    return void_type;
-}
-
-sym_index ast_lvalue::type_check()
-{
-    fatal("Trying to type check abstract class ast_lvalue.");
-    return void_type;
-}
-
-sym_index ast_binaryoperation::type_check()
-{
-    fatal("Trying to type check abstract class ast_binaryoperation.");
-    return void_type;
-}
-
-sym_index ast_binaryrelation::type_check()
-{
-    fatal("Trying to type check abstract class ast_binaryrelation.");
+    fatal("Trying to type check an abstract or unknown AST node.");
     return void_type;
 }
 
 
 
 /* Type check a list of statements. */
-sym_index ast_stmt_list::type_check()
+sym_index semantic::visit_stmt_list(ast_stmt_list *node)
 {
-    if (preceding != NULL) {
-        preceding->type_check();
-    }
-    if (last_stmt != NULL) {
-        last_stmt->type_check();
+    for (int i = 0; i < node->stmts.size(); i++) {
+        visit(node->stmts[i]);
+        if (folding) {
+            finish_folds();
+        }
     }
     return void_type;
 }
 
 
 /* Type check a list of expressions. */
-sym_index ast_expr_list::type_check()
+sym_index semantic::visit_expr_list(ast_expr_list *node)
 {
     /* Your code here */
-    if (preceding != NULL)
+    for (int i = 0; i < node->exprs.size(); i++)
     {
-        preceding->type_check();
-    }
-    if (last_expr != NULL)
-    {
-        last_expr->type_check();
+        if (node->exprs[i] != NULL)
+        {
+            visit(node->exprs[i]);
+            fold(node->exprs[i]);
+        }
     }
     return void_type;
 }
@@ -194,16 +288,15 @@ sym_index ast_expr_list::type_check()
 
 
 /* Type check an elsif list. */
-sym_index ast_elsif_list::type_check()
+sym_index semantic::visit_elsif_list(ast_elsif_list *node)
 {
     /* Your code here */
-    if (preceding != NULL)
+    for (int i = 0; i < node->elsifs.size(); i++)
     {
-        preceding->type_check();
-    }
-    if (last_elsif != NULL)
-    {
-        last_elsif->type_check();
+        if (node->elsifs[i] != NULL)
+        {
+            visit(node->elsifs[i]);
+        }
     }
     return void_type;
 }
@@ -212,23 +305,27 @@ sym_index ast_elsif_list::type_check()
 /* "type check" an indentifier. We need to separate nametypes from other types
    here, since all nametypes are of type void, but should return an index to
    itself in the symbol table as far as typechecking is concerned. */
-sym_index ast_id::type_check()
+sym_index semantic::visit_id(ast_id *node)
 {
-    if (sym_tab->get_symbol(sym_p)->tag != SYM_NAMETYPE) {
-        return type;
+    if (sym_tab->get_symbol_tag(node->sym_p) != SYM_NAMETYPE) {
+        return node->type;
     }
-    return sym_p;
+    return node->sym_p;
 }
 
 
-sym_index ast_indexed::type_check()
+sym_index semantic::visit_indexed(ast_indexed *node)
 {
     /* Your code here */
-    if (index->type_check() != integer_type)
+    size_t index_folds = folds.size();
+    if (visit(node->index) != integer_type)
     {
-        type_error(pos) << "List index of non-integer type: " << index << endl;
+        // The index is shown as it was before folding.
+        swap_folds(index_folds, folds.size(), true);
+        type_error(node->pos) << "List index of non-integer type: " << node->index << endl;
+        swap_folds(index_folds, folds.size(), false);
     }
-    return type = id->type_check();
+    return node->type = visit(node->id);
 }
 
 
@@ -238,63 +335,75 @@ sym_index ast_indexed::type_check()
    multiplication. We synthesize type information as well. */
 sym_index semantic::type_check_and_cast_real(ast_binaryoperation *operation)
 {
-    sym_index left_type = operation->left->type_check();
-    sym_index right_type = operation->right->type_check();
+    size_t left_folds = folds.size();
+    sym_index left_type = visit(operation->left);
+    size_t right_folds = folds.size();
+    sym_index right_type = visit(operation->right);
     if (left_type == void_type || right_type == void_type)
     {
         type_error(operation->pos) << "Binary operations with void types" << endl;
     }
 
+    sym_index type = real_type;
     if (left_type == right_type)
     {
-        return left_type;
+        type = left_type;
     }
-    
-    if (left_type == real_type && right_type == integer_type)
+    else if (left_type == real_type && right_type == integer_type)
     {
+        take_back_folds(right_folds, folds.size());
         operation->right = new ast_cast(operation->pos, operation->right);
     }
     else if(left_type == integer_type && right_type == real_type)
     {
+        take_back_folds(left_folds, right_folds);
         operation->left = new ast_cast(operation->pos, operation->left);
     }
-    return real_type;
+    fold(operation->left);
+    fold(operation->right);
+    return type;
 }
 
-sym_index ast_add::type_check()
+sym_index semantic::visit_add(ast_add *node)
 {
     /* Your code here */
-    return type = type_checker->type_check_and_cast_real(this);
+    return node->type = type_check_and_cast_real(node);
 }
 
-sym_index ast_sub::type_check()
+sym_index semantic::visit_sub(ast_sub *node)
 {
     /* Your code here */
-    return type = type_checker->type_check_and_cast_real(this);
+    return node->type = type_check_and_cast_real(node);
 }
 
-sym_index ast_mult::type_check()
+sym_index semantic::visit_mult(ast_mult *node)
 {
     /* Your code here */
-    return type = type_checker->type_check_and_cast_real(this);
+    return node->type = type_check_and_cast_real(node);
 }
 
 /* Divide is a special case, since it always returns real. We make sure the
    operands are cast to real too as needed. */
-sym_index ast_divide::type_check()
+sym_index semantic::visit_divide(ast_divide *node)
 {
     /* Your code here */
-    sym_index left_type = left->type_check();
-    sym_index right_type = right->type_check();
-    if (left_type == integer_type)
+    size_t left_folds = folds.size();
+    sym_index left_type = visit(node->left);
+    size_t right_folds = folds.size();
+    sym_index right_type = visit(node->right);
+    if (right_type == integer_type)
     {
-        left = new ast_cast(left->pos, left);
+        take_back_folds(right_folds, folds.size());
+        node->right = new ast_cast(node->right->pos, node->right);
     }
-    if (right_type == integer_type)
+    if (left_type == integer_type)
     {
-        right = new ast_cast(right->pos, right);
+        take_back_folds(left_folds, right_folds);
+        node->left = new ast_cast(node->left->pos, node->left);
     }
-    return type = real_type;
+    fold(node->left);
+    fold(node->right);
+    return node->type = real_type;
 }
 
 /* This convenience method is used to type check all binary operations
@@ -303,40 +412,42 @@ sym_index ast_divide::type_check()
    good error message.
    All of these return integers, so we synthesize that.
    */
-sym_index semantic::type_check_integers(ast_binaryoperation *operation, string s)
+sym_index semantic::type_check_integers(ast_binaryoperation *operation, const char *s)
 {
     /* Your code here */
-    sym_index left_type = operation->left->type_check();
-    sym_index right_type = operation->right->type_check();
+    sym_index left_type = visit(operation->left);
+    sym_index right_type = visit(operation->right);
     if (left_type != integer_type || right_type != integer_type)
     {
         type_error(operation->pos) << "Integer binary operation " << s << " with non-integer types" << endl;
     }
+    fold(operation->left);
+    fold(operation->right);
     return integer_type;
 }
 
-sym_index ast_or::type_check()
+sym_index semantic::visit_or(ast_or *node)
 {
     /* Your code here */
-    return type = type_checker->type_check_integers(this, "OR");
+    return node->type = type_check_integers(node, "OR");
 }
 
-sym_index ast_and::type_check()
+sym_index semantic::visit_and(ast_and *node)
 {
     /* Your code here */
-    return type = type_checker->type_check_integers(this, "AND");
+    return node->type = type_check_integers(node, "AND");
 }
 
-sym_index ast_idiv::type_check()
+sym_index semantic::visit_idiv(ast_idiv *node)
 {
     /* Your code here */
-    return type = type_checker->type_check_integers(this, "IDIV");
+    return node->type = type_check_integers(node, "IDIV");
 }
 
-sym_index ast_mod::type_check()
+sym_index semantic::visit_mod(ast_mod *node)
 {
     /* Your code here */
-    return type = type_checker->type_check_integers(this, "MOD");
+    return node->type = type_check_integers(node, "MOD");
 }
 
 
@@ -345,117 +456,111 @@ sym_index ast_mod::type_check()
    the same way. They all return integer types, 1 = true, 0 = false. */
 sym_index semantic::check_binrel(ast_binaryrelation *relation)
 {
-    sym_index left_type = relation->left->type_check();
-    sym_index right_type = relation->right->type_check();
+    size_t left_folds = folds.size();
+    sym_index left_type = visit(relation->left);
+    size_t right_folds = folds.size();
+    sym_index right_type = visit(relation->right);
     if (left_type == void_type || right_type == void_type)
     {
         type_error(relation->pos) << "Binary relation with void types" << endl;    
     }
 
-    if (left_type == right_type)
-    {
-        return integer_type;
-    }
-    
     if (left_type == real_type && right_type == integer_type)
     {
+        take_back_folds(right_folds, folds.size());
         relation->right = new ast_cast(relation->pos, relation->right);
     }
     else if(left_type == integer_type && right_type == real_type)
     {
+        take_back_folds(left_folds, right_folds);
         relation->left = new ast_cast(relation->pos, relation->left);
     }
+    fold(relation->left);
+    fold(relation->right);
     return integer_type;
 }
 
-sym_index ast_equal::type_check()
-{
-    /* Your code here */
-    return type_checker->check_binrel(this);
-}
-
-sym_index ast_notequal::type_check()
-{
-    /* Your code here */
-    return type_checker->check_binrel(this);
-}
-
-sym_index ast_lessthan::type_check()
+/* Equal, notequal, lessthan and greaterthan all end up here. */
+sym_index semantic::visit_binaryrelation(ast_binaryrelation *node)
 {
     /* Your code here */
-    return type_checker->check_binrel(this);
-}
-
-sym_index ast_greaterthan::type_check()
-{
-    /* Your code here */
-    return type_checker->check_binrel(this);
+    return check_binrel(node);
 }
 
 
 
 /*** The various classes derived from ast_statement. ***/
 
-sym_index ast_procedurecall::type_check()
+sym_index semantic::visit_procedurecall(ast_procedurecall *node)
 {
     /* Your code here */
-    type_checker->check_parameters(this->id, this->parameter_list);
+    check_parameters(node->id, node->parameter_list);
     return void_type;
 }
 
 
-sym_index ast_assign::type_check()
+sym_index semantic::visit_assign(ast_assign *node)
 {
     /* Your code here */
-    sym_index left_type = lhs->type_check();
-    sym_index right_type = rhs->type_check();
+    // The optimizer leaves the left hand side alone.
+    bool was_folding = folding;
+    folding = false;
+    sym_index left_type = visit(node->lhs);
+    folding = was_folding;
+
+    size_t rhs_folds = folds.size();
+    sym_index right_type = visit(node->rhs);
     if (left_type == integer_type && right_type == real_type)
     {
-        type_error(rhs->pos) << "Can't assign a real value to an integer variable." << endl;
+        type_error(node->rhs->pos) << "Can't assign a real value to an integer variable." << endl;
     }
     if (left_type == real_type && right_type == integer_type)
     {
-        rhs = new ast_cast(rhs->pos, rhs);
+        take_back_folds(rhs_folds, folds.size());
+        node->rhs = new ast_cast(node->rhs->pos, node->rhs);
     }
+    fold(node->rhs);
     return void_type;
 }
 
 
-sym_index ast_while::type_check()
+sym_index semantic::visit_while(ast_while *node)
 {
-    if (condition->type_check() != integer_type) {
-        type_error(condition->pos) << "while predicate must be of integer "
-                                   << "type.\n";
+    if (visit(node->condition) != integer_type) {
+        type_error(node->condition->pos) << "while predicate must be of integer "
+                                         << "type.\n";
     }
+    fold(node->condition);
 
-    if (body != NULL) {
-        body->type_check();
+    if (node->body != NULL) {
+        visit(node->body);
     }
     return void_type;
 }
 
 
-sym_index ast_if::type_check()
+sym_index semantic::visit_if(ast_if *node)
 {
     /* Your code here */
-    condition->type_check();
-    if (body != NULL)
+    visit(node->condition);
+    fold(node->condition);
+    if (node->body != NULL)
     {
-        body->type_check();
+        visit(node->body);
     }
-    if (elsif_list != NULL)
+    if (node->elsif_list != NULL)
     {
-        elsif_list->type_check();    
+        visit(node->elsif_list);
     }
-    if (else_body != NULL)
+    if (node->else_body != NULL)
     {
-        else_body->type_check();
+        visit(node->else_body);
     }
     return void_type;
 }
 
 
-sym_index ast_return::type_check()
+sym_index semantic::visit_return(ast_return *node)
 {
     // This static global (meaning it is global for all methods in this file,
     // but not visible outside this file) variable is reset to 0 every time
@@ -466,95 +571,97 @@ sym_index ast_return::type_check()
 
     // Get the current environment. We don't yet know if it's a procedure or
     // a function.
-    symbol *tmp = sym_tab->get_symbol(sym_tab->current_environment());
-    if (value == NULL) {
+    sym_index env = sym_tab->current_environment();
+    if (node->value == NULL) {
         // If the return value is NULL,
-        if (tmp->tag != SYM_PROC)
+        if (sym_tab->get_symbol_tag(env) != SYM_PROC)
             // ...and we're not inside a procedure, something is wrong.
         {
-            type_error(pos) << "Must return a value from a function.\n";
+            type_error(node->pos) << "Must return a value from a function.\n";
         }
         return void_type;
     }
 
-    sym_index value_type = value->type_check();
+    sym_index value_type = visit(node->value);
+    fold(node->value);
 
     // The return value is not NULL,
-    if (tmp->tag != SYM_FUNC) {
+    if (sym_tab->get_symbol_tag(env) != SYM_FUNC) {
         // ...so if we're not inside a function, something is wrong too.
-        type_error(pos) << "Procedures may not return a value.\n";
+        type_error(node->pos) << "Procedures may not return a value.\n";
         return void_type;
     }
 
-    // Now we know it's a function and can safely downcast.
-    function_symbol *func = tmp->get_function_symbol();
-
-    // Must make sure that the return type matches the function's
-    // declared return type.
-    if (func->type != value_type) {
-        type_error(value->pos) << "Bad return type from function.\n";
+    // Now we know it's a function. Must make sure that the return type
+    // matches the function's declared return type.
+    if (sym_tab->get_symbol_type(env) != value_type) {
+        type_error(node->value->pos) << "Bad return type from function.\n";
     }
 
     return void_type;
 }
 
 
-sym_index ast_functioncall::type_check()
+sym_index semantic::visit_functioncall(ast_functioncall *node)
 {
     /* Your code here */
-    symbol *sym = sym_tab->get_symbol(id->sym_p);
-    if (sym->tag != SYM_FUNC)
+    sym_type tag = sym_tab->get_symbol_tag(node->id->sym_p);
+    if (tag != SYM_FUNC)
     {
-        type_error(pos) << sym->tag << " not of function type " << endl;
+        type_error(node->pos) << tag << " not of function type " << endl;
+        fold_unchecked(node->parameter_list, 0);
         return void_type;
     }    
 
-    type_checker->check_parameters(id, parameter_list);
-    return sym->type;
+    check_parameters(node->id, node->parameter_list);
+    return sym_tab->get_symbol_type(node->id->sym_p);
 }
 
-sym_index ast_uminus::type_check()
+sym_index semantic::visit_uminus(ast_uminus *node)
 {
     /* Your code here */
-    sym_index type1 = expr->type_check();
+    sym_index type1 = visit(node->expr);
+    fold(node->expr);
     if (type1 == void_type)
     {
-        type_error(pos) << "Unary of type void" << endl;
+        type_error(node->pos) << "Unary of type void" << endl;
     }
     
-    return type = type1;
+    return node->type = type1;
 }
 
-sym_index ast_not::type_check()
+sym_index semantic::visit_not(ast_not *node)
 {
     /* Your code here */
-    sym_index type = expr->type_check();
+    sym_index type = visit(node->expr);
+    fold(node->expr);
     if (type != integer_type)
     {
-        type_error(pos) << "Logical negation on non-integer" << endl;
+        type_error(node->pos) << "Logical negation on non-integer" << endl;
     }
     return integer_type;
 }
 
 
-sym_index ast_elsif::type_check()
+sym_index semantic::visit_elsif(ast_elsif *node)
 {
-    condition->type_check();
-    if (body != NULL)
+    visit(node->condition);
+    fold(node->condition);
+    if (node->body != NULL)
     {
-        body->type_check();
+        visit(node->body);
     }
     return void_type;
 }
 
 
 
-sym_index ast_integer::type_check()
+sym_index semantic::visit_integer(ast_integer *node)
 {
     return integer_type;
 }
 
-sym_index ast_real::type_check()
+sym_index semantic::visit_real(ast_real *node)
 {
     return real_type;
 }
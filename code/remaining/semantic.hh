@@ -1,7 +1,9 @@
 #ifndef __SEMANTIC_HH__
 #define __SEMANTIC_HH__
 
+#include <vector>
 #include "ast.hh"
+#include "visitor.hh"
 
 class semantic;
 
@@ -10,13 +12,47 @@ class semantic;
 extern semantic *type_checker;
 
 
-class semantic
+/*** This class type checks the AST. It is a pass over the AST, see
+     visitor.hh: visit() type checks a node and its children, returning
+     the type of the node, and inserts casts from integer to real where
+     they are needed. ***/
+class semantic : public ast_visitor<semantic, sym_index>
 {
 private:
     // Check formal vs actual parameters. This function recurses down the
     // parameter lists. Called by check_parameters.
     bool chk_param(ast_id *, parameter_symbol *, ast_expr_list *);
+
+    // A change folding has made to the AST: the place in the AST and what
+    // it held before. With NULL, the place holds parameters that were not
+    // type checked, which are optimized at the end of the statement.
+    struct fold_record
+    {
+        ast_expression **place;
+        ast_expression  *other;
+    };
+
+    // True while type checking in do_typecheck_and_fold().
+    bool folding;
+
+    // The changes made while type checking the current statement. Those
+    // made below a node that gets cast are taken back, since the optimizer
+    // leaves whatever is below a cast alone.
+    vector<fold_record> folds;
+
+    // Fold the node in a place in the AST, when folding.
+    void fold(ast_expression *&);
+    // Leave the parameters from an index on to the optimizer, when folding.
+    void fold_unchecked(ast_expr_list *, int);
+    // Take back the changes in a range of folds for good.
+    void take_back_folds(size_t from, size_t to);
+    // Undo or redo the changes in a range of folds.
+    void swap_folds(size_t from, size_t to, bool undo);
+    // Optimize the parameters left over, and forget the statement's folds.
+    void finish_folds();
 public:
+    semantic();
+
     /*! \brief Compare formal vs. actual parameters in function/procedure calls.
 
     It is also responsible for making sure that parameters are type-checked.
@@ -35,6 +71,15 @@ public:
     */
     void do_typecheck(symbol *env, ast_stmt_list *body);
 
+    /*! \brief Type check a block and fold its constants in the same pass.
+
+    Each node is folded as soon as it has been type checked and given its
+    casts, so the block is only walked once. The errors reported and the
+    AST left behind are the same as with do_typecheck() followed by
+    ast_optimizer::do_optimize().
+    */
+    void do_typecheck_and_fold(symbol *env, ast_stmt_list *body);
+
     // Perform type checking on a procedure/function/program body. Note that
     // the body is represented as an ast_stmt_list. See the productions for
     // comp_stmt and subprog_decl in parser.y.
@@ -42,11 +87,40 @@ public:
     // one for binary_relations, one for conditions (new abstract ast_node?),
     // one for expressions that aren't one of the above? Hmmm...
 
-    sym_index type_check_integers(ast_binaryoperation *, string);
+    sym_index type_check_integers(ast_binaryoperation *, const char *);
 
     sym_index check_binrel(ast_binaryrelation *);
 
     sym_index type_check_and_cast_real(ast_binaryoperation *);
+
+    // The methods of the pass, one for each concrete AST class that can be
+    // type checked. See semantic.cc for the method bodies.
+    sym_index visit_node(ast_node *);
+    sym_index visit_stmt_list(ast_stmt_list *);
+    sym_index visit_expr_list(ast_expr_list *);
+    sym_index visit_elsif_list(ast_elsif_list *);
+    sym_index visit_id(ast_id *);
+    sym_index visit_indexed(ast_indexed *);
+    sym_index visit_add(ast_add *);
+    sym_index visit_sub(ast_sub *);
+    sym_index visit_mult(ast_mult *);
+    sym_index visit_divide(ast_divide *);
+    sym_index visit_or(ast_or *);
+    sym_index visit_and(ast_and *);
+    sym_index visit_idiv(ast_idiv *);
+    sym_index visit_mod(ast_mod *);
+    sym_index visit_binaryrelation(ast_binaryrelation *);
+    sym_index visit_procedurecall(ast_procedurecall *);
+    sym_index visit_assign(ast_assign *);
+    sym_index visit_while(ast_while *);
+    sym_index visit_if(ast_if *);
+    sym_index visit_return(ast_return *);
+    sym_index visit_functioncall(ast_functioncall *);
+    sym_index visit_uminus(ast_uminus *);
+    sym_index visit_not(ast_not *);
+    sym_index visit_elsif(ast_elsif *);
+    sym_index visit_integer(ast_integer *);
+    sym_index visit_real(ast_real *);
 };
 
 
@@ -1,3 +1,4 @@
+#include <stdio.h>
 #include "symtab.hh"
 
 /***************************************
@@ -91,7 +92,7 @@ nametype_symbol::nametype_symbol(const pool_index pool_p) :
 
 // This is the default detail level of information given when printing a
 // symbol.
-symbol::format_type symbol::output_format = symbol::LONG_FORMAT;
+thread_local symbol::format_type symbol::output_format = symbol::LONG_FORMAT;
 
 
 /* Prints information common to all symbols. The various subclasses add on
@@ -188,6 +189,21 @@ ostream &operator<<(ostream &o, symbol *sym)
 }
 
 
+/* Output stream operator for a sym_index. Temporaries are printed by their
+   name, padded to MAX_TEMP_VAR_LENGTH like installed names used to be. */
+ostream &operator<<(ostream &o, const sym_ref &ref)
+{
+    if (ref.sym != NULL_SYM && sym_tab->is_temp(ref.sym)) {
+        char name[MAX_TEMP_VAR_LENGTH + 1];
+        snprintf(name, sizeof(name), "$%-*ld", MAX_TEMP_VAR_LENGTH - 1,
+                 sym_tab->get_temp_number(ref.sym));
+        return o << name;
+    }
+
+    return o << sym_tab->get_symbol(ref.sym);
+}
+
+
 /* Print data about a constant. Helps debugging a lot. See the stream operator
    though, that's the easiest way to get this info printed. Note that a
    constant can be integer _or_ real. */
@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <limits.h>
 #include <assert.h>
 #include <iomanip>
 #include <fstream>
@@ -10,6 +11,62 @@
 
 using namespace std;
 
+/* String pool entries are prefixed with their length. Lengths below
+   POOL_LONG_LENGTH take a single byte; longer ones are stored as
+   POOL_LONG_LENGTH followed by four bytes, least significant first.
+   POOL_CHUNK_END never starts an entry; it marks the unused tail of a
+   chunk. */
+static const unsigned char POOL_LONG_LENGTH = 0xFE;
+static const unsigned char POOL_CHUNK_END = 0xFF;
+
+/* Bytes needed for the length prefix of a string of the given length. */
+static int pool_prefix_size(long length)
+{
+    return length < POOL_LONG_LENGTH ? 1 : 5;
+}
+
+/* Write the length prefix of an entry. Returns where the string goes. */
+static char *pool_write_prefix(char *entry, long length)
+{
+    if (length < POOL_LONG_LENGTH) {
+        *entry++ = (char) length;
+    } else {
+        *entry++ = (char) POOL_LONG_LENGTH;
+        for (int i = 0; i < 4; i++) {
+            *entry++ = (char) ((length >> (8 * i)) & 0xFF);
+        }
+    }
+    return entry;
+}
+
+/* FNV-1a, as used by string_hash(). The steps are also used directly by
+   the scanner's install path, which hashes while it case folds. */
+static const unsigned long HASH_BASIS = 14695981039346656037UL;
+static const unsigned long HASH_PRIME = 1099511628211UL;
+
+static inline unsigned long hash_finish(unsigned long h)
+{
+    return h ^ (h >> 32);
+}
+
+/* Whether the pool string at str is the text from s to end as the
+   scanner's install path folds it: upper cased and, if quoted, with
+   doubled quotes compacted. The caller has checked the length. */
+static bool folded_equal(const char *str, const char *s, const char *end,
+                         bool quoted)
+{
+    for (const char *c = s; c < end; c++) {
+        unsigned char ch = (unsigned char) toupper((unsigned char) *c);
+        if (quoted && ch == '\'') {
+            c++;
+        }
+        if ((unsigned char) *str++ != ch) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /*** Global variables ***/
 
 // The symbol table is a table of pointers to symbol (which can be of various types)
@@ -36,35 +93,71 @@ symbol_table::symbol_table()
 
      // Always points to the last position in the string pool
     pool_pos = 0;
-    // Set base size of string pool. Can be extended later on,
-    // if there are many symbols to scan.
-    pool_length = BASE_POOL_SIZE;
-
-    // create a string with length of pool_length
-    string_pool = new char[pool_length];
-    string_pool[0] = '\0';
+    // Start with a single chunk. More are added, never copied, if there
+    // are many symbols to scan.
+    pool_chunk_count = 0;
+    pool_chunk_cap = 8;
+    pool_chunks = new char*[pool_chunk_cap];
+    pool_chunk_owned = new bool[pool_chunk_cap];
+    pool_add_chunk(1);
+
+    // --- Initialize string intern index. ---
+    intern_size = BASE_INTERN_SIZE;
+    intern_count = 0;
+    intern_table = new pool_index[intern_size];
+    for (long i = 0; i < intern_size; i++) {
+        intern_table[i] = NULL_SYM;
+    }
 
     // --- Initialize hash table. ---
-    hash_table = new sym_index[MAX_HASH];
-    for (int i = 0; i < MAX_HASH; i++) {
+    hash_size = BASE_HASH_SIZE;
+    hash_table = new sym_index[hash_size];
+    for (hash_index i = 0; i < hash_size; i++) {
         hash_table[i] = NULL_SYM;
     }
 
+    // --- Initialize scope undo log. ---
+    scope_log_size = BASE_SYM_SIZE;
+    scope_log_pos = 0;
+    scope_log = new sym_index[scope_log_size];
+
     // --- Initialize display. ---
     // The block_table will keep track of the current lexical level
     // global level is 0
     current_level = 0;
-    block_table = new sym_index[MAX_BLOCK];
-    for (int i = 0; i < MAX_BLOCK; i++) {
+    block_size = BASE_BLOCK_SIZE;
+    block_table = new sym_index[block_size];
+    scope_marks = new scope_mark[block_size];
+    for (int i = 0; i < block_size; i++) {
         block_table[i] = 0;
+        memset(&scope_marks[i], 0, sizeof(scope_mark));
     }
+    closed_env = NULL_SYM;
+    resumed_from = 0;
+    resumed_block = 0;
 
     // --- Initialize symbol table. ---
     // Weird syntax, gives us a table of pointers to symbols.
-    sym_table = new symbol*[MAX_SYM];
-    for (int i = 0; i < MAX_SYM; i++) {
+    sym_size = BASE_SYM_SIZE;
+    sym_table = new symbol*[sym_size];
+    for (sym_index i = 0; i < sym_size; i++) {
         sym_table[i] = NULL;
     }
+    sym_tags = new sym_type[sym_size];
+    sym_types = new sym_index[sym_size];
+    sym_levels = new block_level[sym_size];
+    sym_offsets = new int[sym_size];
+    sym_details = new symbol_detail[sym_size];
+
+    // --- Initialize temporary variable table. ---
+    temp_size = BASE_TEMP_SIZE;
+    temp_count = 0;
+    temps = new temp_variable[temp_size];
+    temp_env = NULL_SYM;
+
+    space_size = 0;
+    space_count = 0;
+    spaces = NULL;
 
     label_nr = -1;
     temp_nr = 0;
@@ -80,7 +173,7 @@ symbol_table::symbol_table()
         return;
     }
     // This is just a dummy position for the preinstalled functions.
-    position_information *dummy_pos = new position_information();
+    position_information dummy_pos;
 
     // This "empty" symbol represents the global level.
     enter_procedure(dummy_pos, pool_install(capitalize("global.")));
@@ -139,6 +232,42 @@ symbol_table::symbol_table()
     truc->get_function_symbol()->last_parameter = par;
 
     sym_table[0]->get_procedure_symbol()->last_parameter = NULL;
+
+    // Some fields above were set directly on the symbols.
+    for (sym_index i = 0; i <= sym_pos; i++) {
+        sync_symbol(i);
+    }
+}
+
+
+/* Destructor: frees the tables and the string pool. The symbols are freed
+   in bulk by the arena's destructor. */
+symbol_table::~symbol_table()
+{
+    for (long i = 0; i < pool_chunk_count; i++) {
+        if (pool_chunk_owned[i]) {
+            delete[] pool_chunks[i];
+        }
+    }
+    delete[] pool_chunks;
+    delete[] pool_chunk_owned;
+    delete[] intern_table;
+    delete[] hash_table;
+    delete[] block_table;
+    delete[] scope_marks;
+    delete[] scope_log;
+    delete[] sym_table;
+    delete[] sym_tags;
+    delete[] sym_types;
+    delete[] sym_levels;
+    delete[] sym_offsets;
+    delete[] sym_details;
+    delete[] temps;
+    for (long i = 0; i < space_count; i++) {
+        delete[] spaces[i]->temps;
+        delete spaces[i];
+    }
+    delete[] spaces;
 }
 
 
@@ -159,26 +288,82 @@ long symbol_table::ieee(double d) {
 }
 
 
+/* The backend space the calling thread takes labels and temporaries from,
+   if any. See use_backend_space(). */
+static thread_local backend_space *active_space = NULL;
+
+
 /* This function generates assembler label numbers. */
 long symbol_table::get_next_label()
 {
+    if (active_space != NULL) {
+        if (active_space->next_label == active_space->label_end) {
+            fatal("Too many labels in one block");
+        }
+        return active_space->next_label++;
+    }
+
     // Labels start on -1 (which is the global level, meaning that all labels
     // generated for user-defined functions etc start with 0).
     return label_nr++;
 }
 
 
-/* Generate a unique temporary variable name. We do it without any extra fuss:
-   $1, $2, $3, $4 ... up to 1 million. Diesel isn't written to handle that
-   large programs anyway. The type should never be void_type; if it is, it's
-   an error. This method is used for quad generation. */
+/* Generate a temporary variable. Temporaries are numbered $1, $2, $3 ...
+   starting over in each function, and are kept in the temps table rather
+   than installed as symbols, so they cost neither a string in the pool nor
+   a hash table entry. They still get a slot in the activation record of
+   the current environment. The type should never be void_type; if it is,
+   it's an error. This method is used for quad generation. */
 sym_index symbol_table::gen_temp_var(sym_index type)
 {
-    /* Your code here */
-    char tmp[MAX_TEMP_VAR_LENGTH];
-    snprintf(tmp, MAX_TEMP_VAR_LENGTH + 1, "$%ld      ", ++temp_nr);
-    pool_index pool_p = pool_install(tmp);
-    return enter_variable(pool_p, type);
+    // A block compiled on a worker thread numbers its temporaries in its
+    // own space.
+    if (active_space != NULL) {
+        backend_space *space = active_space;
+        if (space->temp_count == 1L << TEMP_SPACE_SHIFT) {
+            fatal("Too many temporaries in one block");
+        }
+        if (space->temp_count >= space->temp_size) {
+            temp_variable *tmp_temps = new temp_variable[2 * space->temp_size];
+            memcpy(tmp_temps, space->temps,
+                   space->temp_size * sizeof(temp_variable));
+            delete[] space->temps;
+            space->temps = tmp_temps;
+            space->temp_size *= 2;
+        }
+
+        temp_variable *temp = &space->temps[space->temp_count];
+        temp->type = type;
+        temp->level = space->level;
+        temp->offset = allocate_frame_slot(get_size(type));
+        temp->number = space->temp_count + 1;
+
+        return TEMP_SYM_BASE + (space->number << TEMP_SPACE_SHIFT) +
+            space->temp_count++;
+    }
+
+    // Restart the numbering when we generate code for a new function.
+    if (temp_env != current_environment()) {
+        temp_env = current_environment();
+        temp_nr = 0;
+    }
+
+    if (temp_count >= temp_size) {
+        temp_variable *tmp_temps = new temp_variable[2 * temp_size];
+        memcpy(tmp_temps, temps, temp_size * sizeof(temp_variable));
+        delete[] temps;
+        temps = tmp_temps;
+        temp_size *= 2;
+    }
+
+    temp_variable *temp = &temps[temp_count];
+    temp->type = type;
+    temp->level = current_level;
+    temp->offset = allocate_frame_slot(get_size(type));
+    temp->number = ++temp_nr;
+
+    return TEMP_SYM_BASE + temp_count++;
 }
 
 
@@ -210,7 +395,8 @@ int symbol_table::get_size(const sym_index type)
 /* This function prints the contents of the symbol table.
     Args: 1     - print a one-liner for each symbol with relevant data.
       2     - only print the string table showing the current pool_pos.
-      3     - dump the nonzero elements in the hash table.
+      3     - dump the nonempty buckets of the hash table, followed by
+              load factor and chain length statistics.
       other - dump detailed info about every symbol in the table. Watch
           out, this gets _very_ long if you have more than a few
           symbols installed. */
@@ -218,18 +404,20 @@ void symbol_table::print(int detail)
 {
     if (detail == 2) {
         if (pool_pos > 0) {
-            unsigned int pos = 0;
-            while (pos < strlen(string_pool)) {
-                unsigned int len = (int) string_pool[pos];
-                cout << len;
-                for (unsigned int k = pos + 1; k < pos + len + 1; k++) {
-                    cout << string_pool[k];
+            pool_index pos = 0;
+            while (pos < pool_pos) {
+                // Skip the unused tail of a chunk.
+                if ((unsigned char) *pool_address(pos) == POOL_CHUNK_END) {
+                    pos = (pos / POOL_CHUNK_SIZE + 1) * POOL_CHUNK_SIZE;
+                    continue;
                 }
-                pos += len + 1;
+                pool_string view = pool_view(pos);
+                cout << view.length;
+                cout.write(view.str, view.length);
+                pos += pool_prefix_size(view.length) + view.length;
             }
             cout << endl;
 
-            // cout << string_pool << endl;
             for (int j = 0; j < pool_pos; j++) {
                 cout << "-";
             }
@@ -242,11 +430,31 @@ void symbol_table::print(int detail)
 
     if (detail == 3) {
         cout << "Hash table:\n";
-        for (int j = 0; j < MAX_HASH; j++) {
-            if (hash_table[j]) {
-                cout << j << ": " << hash_table[j] << endl;
+        long used = 0;
+        long longest = 0;
+        for (hash_index j = 0; j < hash_size; j++) {
+            if (hash_table[j] == NULL_SYM) {
+                continue;
+            }
+            long length = 0;
+            for (sym_index i = hash_table[j]; i != NULL_SYM;
+                    i = sym_table[i]->hash_link) {
+                length++;
+            }
+            cout << j << ": " << hash_table[j]
+                 << " (chain length " << length << ")" << endl;
+            used++;
+            if (length > longest) {
+                longest = length;
             }
         }
+        cout << "Buckets: " << hash_size << ", used: " << used
+             << ", symbols: " << scope_log_pos
+             << ", load factor: " << (double) scope_log_pos / hash_size
+             << endl;
+        cout << "Chain length: max " << longest << ", mean "
+             << (used > 0 ? (double) scope_log_pos / used : 0.0)
+             << " over used buckets" << endl;
         return;
     }
 
@@ -272,7 +480,8 @@ void symbol_table::print(int detail)
             cout.flags(ios::right);
             cout << tmp->level
                  << setw(5) << tmp->hash_link << setw(5)
-                 << tmp->back_link << setw(5) << tmp->offset << " ";
+                 << (tmp->back_link & (hash_size - 1)) << setw(5)
+                 << tmp->offset << " ";
 
             cout.flags(ios::left);
             cout << setw(10);
@@ -348,6 +557,28 @@ void symbol_table::print(int detail)
 
 
 
+/* Print memory statistics: how the symbols are laid out in the arena, and
+   how many heap allocations that took compared to one per symbol. */
+void symbol_table::print_statistics()
+{
+    cout << "String pool: " << pool_pos << " bytes in "
+         << pool_chunk_count << " chunk slots of " << POOL_CHUNK_SIZE
+         << " bytes" << endl;
+    cout << "Symbols: " << sym_pos + 1 << " (table size " << sym_size
+         << ")" << endl;
+    cout << "Temporaries: " << temp_count << " (table size " << temp_size
+         << ")" << endl;
+    cout << "Symbol arena: " << sym_arena.objects << " objects, "
+         << sym_arena.bytes_used << " of " << sym_arena.bytes_allocated
+         << " bytes used, " << sym_arena.heap_allocations
+         << " heap allocations (" << sym_arena.objects
+         << " without arena)" << endl;
+    cout << "Symbol arena peak: " << sym_arena.peak_bytes_allocated
+         << " bytes" << endl;
+}
+
+
+
 /*** String pool methods ***/
 
 /* Convenience method for capitalizing strings. Called by the scanner.
@@ -356,125 +587,345 @@ void symbol_table::print(int detail)
 
 char *symbol_table::capitalize(const char *s)
 {
+    size_t length = strlen(s);
+
     // The result string.
-    char *capitalized_s = new char[strlen(s) + 1];
+    char *capitalized_s = new char[length + 1];
 
-    unsigned int i;
-    for (i = 0; i < strlen(s); i++) {
+    for (size_t i = 0; i < length; i++) {
         capitalized_s[i] = (unsigned char) toupper(s[i]);
     }
-    capitalized_s[i] = '\0';
+    capitalized_s[length] = '\0';
 
     return capitalized_s;
 }
 
+/* Hash function for the intern index and the hash table. This is FNV-1a,
+   which spreads short identifiers well and is cheap to compute. The final
+   fold mixes the high bits down, since callers mask off the low ones. */
+unsigned long symbol_table::string_hash(const char *s, int len)
+{
+    unsigned long h = HASH_BASIS;
+    for (int i = 0; i < len; i++) {
+        h ^= (unsigned char) s[i];
+        h *= HASH_PRIME;
+    }
+    return hash_finish(h);
+}
+
+
+/* Probe the intern index for a string. Returns the slot that holds it, or
+   the first free slot on its probe sequence if it is not installed. */
+long symbol_table::intern_slot(const char *s, int len)
+{
+    return intern_slot(s, len, string_hash(s, len));
+}
+
+
+/* As above, for a string whose string_hash() is already known. */
+long symbol_table::intern_slot(const char *s, int len, unsigned long h)
+{
+    long mask = intern_size - 1;
+    long slot = h & mask;
+
+    while (intern_table[slot] != NULL_SYM) {
+        pool_string view = pool_view(intern_table[slot]);
+        if (view.length == len && memcmp(view.str, s, len) == 0) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+
+/* Double the size of the intern index and reinsert every entry. */
+void symbol_table::intern_grow()
+{
+    pool_index *old_table = intern_table;
+    long old_size = intern_size;
+
+    intern_size *= 2;
+    intern_table = new pool_index[intern_size];
+    for (long i = 0; i < intern_size; i++) {
+        intern_table[i] = NULL_SYM;
+    }
+
+    for (long i = 0; i < old_size; i++) {
+        pool_index p = old_table[i];
+        if (p != NULL_SYM) {
+            pool_string view = pool_view(p);
+            intern_table[intern_slot(view.str, view.length)] = p;
+        }
+    }
+    delete[] old_table;
+}
+
+
+/* Remove an entry from the intern index. Since we use linear probing, the
+   entries following it in the same cluster are shifted back so that later
+   probes don't stop at the hole. */
+void symbol_table::intern_remove(const pool_index pool_p)
+{
+    long mask = intern_size - 1;
+    pool_string removed = pool_view(pool_p);
+    long hole = intern_slot(removed.str, removed.length);
+
+    if (intern_table[hole] != pool_p) {
+        return;
+    }
+    intern_table[hole] = NULL_SYM;
+    intern_count--;
+
+    long slot = (hole + 1) & mask;
+    while (intern_table[slot] != NULL_SYM) {
+        pool_index p = intern_table[slot];
+        pool_string view = pool_view(p);
+        long home = string_hash(view.str, view.length) & mask;
+        // Move the entry into the hole unless its home slot lies cyclically
+        // in (hole, slot], in which case it is already reachable.
+        if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+            intern_table[hole] = p;
+            intern_table[slot] = NULL_SYM;
+            hole = slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+
 pool_index symbol_table::find_existing_entry(char *s)
 {
-    int s_len = (int) strlen(s);
-    int p = 0;
-    
-    while(p < pool_pos)
-    {
-        int length = (int) string_pool[p];
-        if (length == s_len)
-        {
-            bool match = true;
-            for (int i = 0; i < length; i++)
-            {
-                if (string_pool[p + 1 + i] != s[i])
-                {
-                    match = false;
-                    break;
-                }
-            }
-            if (match)
-            {
-                return p;
-            }
-        } 
-        p += length + 1;
+    long slot = intern_slot(s, (int) strlen(s));
+    return intern_table[slot];
+}
+
+
+/* Add a chunk to the string pool. It is one allocation that covers the
+   given number of consecutive chunk slots, so that a string longer than
+   POOL_CHUNK_SIZE can still be stored contiguously. Only the table of
+   chunk pointers is ever copied, never the strings. */
+void symbol_table::pool_add_chunk(long slots)
+{
+    if (pool_chunk_count + slots > pool_chunk_cap) {
+        long new_cap = 2 * pool_chunk_cap;
+        while (pool_chunk_count + slots > new_cap) {
+            new_cap *= 2;
+        }
+        char **tmp_chunks = new char*[new_cap];
+        bool *tmp_owned = new bool[new_cap];
+        for (long i = 0; i < pool_chunk_count; i++) {
+            tmp_chunks[i] = pool_chunks[i];
+            tmp_owned[i] = pool_chunk_owned[i];
+        }
+        delete[] pool_chunks;
+        delete[] pool_chunk_owned;
+        pool_chunks = tmp_chunks;
+        pool_chunk_owned = tmp_owned;
+        pool_chunk_cap = new_cap;
     }
-    return NULL_SYM;
+
+    char *chunk = new char[slots * POOL_CHUNK_SIZE];
+    for (long i = 0; i < slots; i++) {
+        pool_chunks[pool_chunk_count + i] = chunk + i * POOL_CHUNK_SIZE;
+        pool_chunk_owned[pool_chunk_count + i] = i == 0;
+    }
+    pool_chunk_count += slots;
 }
 
 
 /* Install a string into the pool table and return its index.
    The table is on the form <string1 length>string1<string2 length>string2...
-   Note that the null char denotes the end of the entire pool,
-   NOT the separator of two strings. It is appended in pool_lookup, though.
+   where the length prefix is one byte for short strings and five bytes for
+   long ones (see POOL_LONG_LENGTH). The strings are not null terminated.
    Snapshot:
-   7INTEGER4REAL4READ5WRITE4PROG1A\0
+   7INTEGER4REAL4READ5WRITE4PROG1A
                   ^
                   pool_pos
 */
 pool_index symbol_table::pool_install(char *s)
 {
-    // Make sure pool is not full. If it is, double pool size.
-    if (pool_pos + 1 + (int) strlen(s) >= pool_length) {
-        char *tmp_pool = new char[2 * pool_length];
+    long length = strlen(s);
 
-        // Double pool size.
-        pool_length *= 2;
-        strcpy(tmp_pool, string_pool);
-        delete[] string_pool;
-        string_pool = tmp_pool;
+    pool_index existing_entry = this->find_existing_entry(s);
+    if (existing_entry != NULL_SYM)
+    {
+        return existing_entry;
     }
 
+    long entry_size = pool_prefix_size(length) + length;
+    char *entry = pool_reserve(entry_size);
+
     // The return value, ie, the start of the string.
     long old_pos = pool_pos;
 
-    // This is not really a pretty solution but it works for now. Some sort
-    // struct with length/char * would be a more general solution, since this
-    // way we're limited to strings that fit within 255 bytes.
-    if (strlen(s) >= 255) {
-        fatal("symbol_table::pool_install: Too long string");
-        return 0;
+    // First install the length of the string, then the string itself.
+    entry = pool_write_prefix(entry, length);
+    memcpy(entry, s, length);
+
+    // Move pool_pos to the end of the new entry.
+    pool_pos += entry_size;
+
+    // Register the new string in the intern index, keeping the load
+    // factor below one half.
+    if (2 * (intern_count + 1) > intern_size) {
+        intern_grow();
     }
+    intern_table[intern_slot(s, (int) length)] = old_pos;
+    intern_count++;
 
-    pool_index existing_entry = this->find_existing_entry(s);
-    if (existing_entry != NULL_SYM)
-    {
-        return existing_entry;
+    return old_pos;
+}
+
+
+/* Make room for an entry of the given size at pool_pos and return its
+   address. An entry must lie within one chunk: if it doesn't fit in what
+   is left of the current one, the rest of the chunk is marked as unused
+   and the entry starts in a new chunk. pool_pos is not moved past the
+   entry; the caller does that once it decides to keep it. */
+char *symbol_table::pool_reserve(long entry_size)
+{
+    long chunk_end = pool_chunk_count * POOL_CHUNK_SIZE;
+    if (pool_pos + entry_size > chunk_end) {
+        if (pool_pos < chunk_end) {
+            *pool_address(pool_pos) = (char) POOL_CHUNK_END;
+        }
+        pool_pos = chunk_end;
+        pool_add_chunk((entry_size + POOL_CHUNK_SIZE - 1) / POOL_CHUNK_SIZE);
     }
+    return pool_address(pool_pos);
+}
 
-    // First install the length of the string.
-    string_pool[pool_pos++] = (unsigned char) strlen(s);
-    string_pool[pool_pos] = '\0';
 
-    // Add the string itself to the end of the pool.
-    strcpy(string_pool+pool_pos, s);
+/* Install an identifier or string constant straight from the scanner's
+   text. The characters are upper cased, and for a string constant the
+   quotes are stripped and doubled quotes compacted. The folded text is
+   hashed and looked up first, so that installing a string that is there
+   already leaves the pool untouched, and only copied to the end of the
+   pool if it is new. Unlike pool_install(fix_string(capitalize(s))) this
+   allocates nothing. */
+pool_index symbol_table::pool_install_folded(const char *s, int length,
+                                             bool quoted)
+{
+    const char *end = s + length;
+    int folded_length = length;
+
+    if (quoted) {
+        // The scanner guarantees that quotes inside come in pairs.
+        assert(length >= 2);
+        s++;
+        end--;
+        folded_length -= 2;
+        for (const char *c = s; c < end; c++) {
+            if (*c == '\'') {
+                folded_length--;
+                c++;
+            }
+        }
+    }
 
-    // Move pool_pos to the end of the new entry.
-    pool_pos += strlen(s);
+    unsigned long h = HASH_BASIS;
+    for (const char *c = s; c < end; c++) {
+        unsigned char ch = (unsigned char) toupper((unsigned char) *c);
+        if (quoted && ch == '\'') {
+            c++;
+        }
+        h ^= ch;
+        h *= HASH_PRIME;
+    }
+    h = hash_finish(h);
+
+    // Probe the intern index as intern_slot() does, comparing against the
+    // text as it will be folded.
+    long mask = intern_size - 1;
+    long slot = h & mask;
+    while (intern_table[slot] != NULL_SYM) {
+        pool_string view = pool_view(intern_table[slot]);
+        if (view.length == folded_length &&
+            folded_equal(view.str, s, end, quoted)) {
+            return intern_table[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    // It is new, so copy it to the end of the pool.
+    long entry_size = pool_prefix_size(folded_length) + folded_length;
+    char *entry = pool_reserve(entry_size);
+    char *dest = pool_write_prefix(entry, folded_length);
+    char *folded = dest;
+    for (const char *c = s; c < end; c++) {
+        char ch = (char) toupper((unsigned char) *c);
+        if (quoted && ch == '\'') {
+            c++;
+        }
+        *dest++ = ch;
+    }
+
+    pool_index old_pos = pool_pos;
+    pool_pos += entry_size;
+
+    if (2 * (intern_count + 1) > intern_size) {
+        intern_grow();
+        slot = intern_slot(folded, folded_length, h);
+    }
+    intern_table[slot] = old_pos;
+    intern_count++;
 
     return old_pos;
 }
 
 
-/* Allocate memory for and return a string given a pool_index. */
+pool_index symbol_table::pool_install_identifier(const char *s, int length)
+{
+    return pool_install_folded(s, length, false);
+}
 
-char *symbol_table::pool_lookup(const pool_index p)
+
+pool_index symbol_table::pool_install_string_constant(const char *s,
+                                                      int length)
 {
-    // Catch references to beyond last string.
-    assert(p < pool_pos);
+    return pool_install_folded(s, length, true);
+}
 
-    // Start points to first char of the sought string.
-    // We just use it to index the pool, it is never assigned to.
-    char *start = &string_pool[p + 1];
 
-    // p points to the char holding the length of the sought string.
-    int length = (int) string_pool[p];
+/* Allocate memory for and return a string given a pool_index. */
+
+char *symbol_table::pool_lookup(const pool_index p)
+{
+    pool_string view = pool_view(p);
 
     // We only want to return a string of length chars, plus
     // one extra for the null terminator.
-    char *s = new char[length + 1];
-    strncpy(s, start, length);
-    s[length] = '\0';
+    char *s = new char[view.length + 1];
+    memcpy(s, view.str, view.length);
+    s[view.length] = '\0';
 
     return s;
 }
 
 
+/* Return a non-owning view of a string given a pool_index. */
+
+pool_string symbol_table::pool_view(const pool_index p)
+{
+    // Catch references to beyond last string.
+    assert(p < pool_pos);
+
+    const unsigned char *entry = (const unsigned char *) pool_address(p);
+
+    pool_string view;
+    if (entry[0] < POOL_LONG_LENGTH) {
+        view.length = entry[0];
+        view.str = (const char *) entry + 1;
+    } else {
+        view.length = entry[1] | (entry[2] << 8) | (entry[3] << 16) |
+                      (entry[4] << 24);
+        view.str = (const char *) entry + 5;
+    }
+    return view;
+}
+
+
 /* Compare two strings. */
 
 bool symbol_table::pool_compare(const pool_index pool_p1,
@@ -483,7 +934,15 @@ bool symbol_table::pool_compare(const pool_index pool_p1,
     // Catch too large pos.
     assert(pool_p1 < pool_pos && pool_p2 < pool_pos);
 
-    return strcmp(pool_lookup(pool_p1), pool_lookup(pool_p2)) == 0;
+    // Installed strings are shared, so equal indices mean equal strings.
+    if (pool_p1 == pool_p2) {
+        return true;
+    }
+
+    pool_string s1 = pool_view(pool_p1);
+    pool_string s2 = pool_view(pool_p2);
+    return s1.length == s2.length &&
+           memcmp(s1.str, s2.str, s1.length) == 0;
 }
 
 
@@ -491,20 +950,57 @@ bool symbol_table::pool_compare(const pool_index pool_p1,
 
 pool_index symbol_table::pool_forget(const pool_index pool_p)
 {
-    char *last_entry = pool_lookup(pool_p);
-
     // Make sure that this really is the last entry.
-    assert((pool_p + (int) strlen(last_entry)) == pool_pos - 1);
+    pool_string view = pool_view(pool_p);
+    assert(pool_p + pool_prefix_size(view.length) + view.length == pool_pos);
+
+    // It must not be found by later installs.
+    intern_remove(pool_p);
 
     // Back up pool_pos one entry.
     pool_pos = pool_p;
-    // Terminate the string pool there.
-    string_pool[pool_pos] = '\0';
     // Mostly useful for debugging.
     return pool_pos;
 }
 
 
+/* Remove every string from pool_p on. They are dropped from the intern
+   index, and the chunks that no longer hold any string are freed. The
+   strings must no longer be referred to. */
+
+void symbol_table::pool_rewind(const pool_index pool_p)
+{
+    assert(pool_p <= pool_pos);
+
+    pool_index pos = pool_p;
+    while (pos < pool_pos) {
+        // Skip the unused tail of a chunk.
+        if ((unsigned char) *pool_address(pos) == POOL_CHUNK_END) {
+            pos = (pos / POOL_CHUNK_SIZE + 1) * POOL_CHUNK_SIZE;
+            continue;
+        }
+        pool_string view = pool_view(pos);
+        intern_remove(pos);
+        pos += pool_prefix_size(view.length) + view.length;
+    }
+
+    // Keep the allocation holding the last remaining byte, including any
+    // further slots it covers, and free the ones after it.
+    long last = pool_p > 0 ? (pool_p - 1) / POOL_CHUNK_SIZE : 0;
+    while (last + 1 < pool_chunk_count && !pool_chunk_owned[last + 1]) {
+        last++;
+    }
+    for (long i = last + 1; i < pool_chunk_count; i++) {
+        if (pool_chunk_owned[i]) {
+            delete[] pool_chunks[i];
+        }
+    }
+    pool_chunk_count = last + 1;
+
+    pool_pos = pool_p;
+}
+
+
 /* Convert a scanned string into a better format: Strip the leading and
    trailing quotes, and convert any internal double quotes to single ones.
    The first arg will be filled in with the fixed string, the second arg is
@@ -512,22 +1008,22 @@ pool_index symbol_table::pool_forget(const pool_index pool_p)
 
 char *symbol_table::fix_string(const char *old_str)
 {
+    size_t length = strlen(old_str);
+
     // Make sure the string is at least ''.
-    assert(strlen(old_str) >= 2);
+    assert(length >= 2);
 
     int new_index = 0;
-    char *new_str = new char[strlen(old_str) - 2 + 1];
+    char *new_str = new char[length - 2 + 1];
 
-    // Start on 1 to skip the first quote. End on strlen-1 to skip the last
+    // Start on 1 to skip the first quote. End on length-1 to skip the last
     // quote.
-    for (unsigned int i = 1; i < strlen(old_str) - 1; i++) {
+    for (size_t i = 1; i < length - 1; i++) {
+        new_str[new_index++] = old_str[i];
         // Compact double quotes to single quotes.
-        if (old_str[i] == '\'' &&
-                i < strlen(old_str) - 2 &&
-                old_str[i + 1] == '\'') {
-            continue;
+        if (old_str[i] == '\'' && i < length - 2 && old_str[i + 1] == '\'') {
+            i++;
         }
-        new_str[new_index++] = old_str[i];
     }
 
     new_str[new_index] = '\0';
@@ -540,22 +1036,36 @@ char *symbol_table::fix_string(const char *old_str)
 
 /*** Hash table methods. ***/
 
-/* Uses the hash_x33 algorithm. Returns an index into the symbol table
-   given a string. The string is probably attained using pool_lookup(). */
+/* Returns an index into the hash table given a string. The string is read
+   in place through pool_view(), and the table size is a power of two so
+   the hash value is masked rather than divided. */
 hash_index symbol_table::hash(const pool_index p)
 {
-    char *s = pool_lookup(p);
-    int len = (int) strlen(s);
-    // Magical hash value variable.
-    unsigned int h = 0;
-    // Calculate the hash value.
-    while (len > 0) {
-        h = (h << 5) + h + *s++;
-        len--;
+    pool_string view = pool_view(p);
+    return string_hash(view.str, view.length) & (hash_size - 1);
+}
+
+
+/* Double the hash table and relink every visible symbol into it. The
+   visible symbols are exactly those in the scope undo log; symbols of
+   closed scopes stay unlinked. Relinking in log order keeps the most
+   recently installed symbol of a name first in its chain, and the cached
+   hash in back_link means no name is rehashed. */
+void symbol_table::hash_grow()
+{
+    delete[] hash_table;
+    hash_size *= 2;
+    hash_table = new sym_index[hash_size];
+    for (hash_index j = 0; j < hash_size; j++) {
+        hash_table[j] = NULL_SYM;
+    }
+
+    for (long k = 0; k < scope_log_pos; k++) {
+        sym_index i = scope_log[k];
+        hash_index h_index = sym_table[i]->back_link & (hash_size - 1);
+        sym_table[i]->hash_link = hash_table[h_index];
+        hash_table[h_index] = i;
     }
-    // Memory leak since s is still allocated. However, since we've
-    // changed it, delete[] s is not a good idea at all.
-    return h % MAX_HASH;
 }
 
 
@@ -565,6 +1075,9 @@ hash_index symbol_table::hash(const pool_index p)
 /* Return sym_index pointer to the current environment, ie, block level. */
 sym_index symbol_table::current_environment()
 {
+    if (active_space != NULL) {
+        return active_space->env;
+    }
     return block_table[current_level];
 }
 
@@ -574,29 +1087,381 @@ void symbol_table::open_scope()
 {
     /* Your code here */
     current_level++;
+    // Double the block table if we are nesting deeper than it allows.
+    if (current_level >= block_size) {
+        sym_index *tmp_block = new sym_index[2 * block_size];
+        scope_mark *tmp_marks = new scope_mark[2 * block_size];
+        memset(tmp_marks, 0, 2 * block_size * sizeof(scope_mark));
+        memcpy(tmp_marks, scope_marks, block_size * sizeof(scope_mark));
+        for (block_level i = 0; i < 2 * block_size; i++) {
+            tmp_block[i] = i < block_size ? block_table[i] : 0;
+        }
+        delete[] block_table;
+        delete[] scope_marks;
+        block_table = tmp_block;
+        scope_marks = tmp_marks;
+        block_size *= 2;
+    }
     block_table[current_level] = sym_pos;
-    // TODO: check if we exceed MAX_BLOCK
+    scope_marks[current_level].log_pos = scope_log_pos;
+    scope_marks[current_level].pool_pos = pool_pos;
+    scope_marks[current_level].temp_count = temp_count;
+    closed_env = NULL_SYM;
 }
 
 
 /* Decrease the current_level by one. Return sym_index to new environment. */
 sym_index symbol_table::close_scope()
 {    
-    for (sym_index i = sym_pos; i > current_environment(); i--)
+    // Unlink the symbols of this scope, newest first. Each one is at the
+    // head of its bucket when we get to it.
+    while (scope_log_pos > scope_marks[current_level].log_pos)
     {
-        hash_index h_index = hash(sym_table[i]->id);
-        if (hash_table[h_index] == i)
-        {
-            hash_table[h_index] = sym_table[i]->hash_link;
-            sym_table[i]->hash_link = NULL_SYM;
-        }
+        sym_index i = scope_log[--scope_log_pos];
+        hash_index h_index = sym_table[i]->back_link & (hash_size - 1);
+        assert(hash_table[h_index] == i);
+        hash_table[h_index] = sym_table[i]->hash_link;
+        sym_table[i]->hash_link = NULL_SYM;
     }
+    closed_env = block_table[current_level];
+    closed_mark = scope_marks[current_level];
     block_table[current_level] = 0;
+    memset(&scope_marks[current_level], 0, sizeof(scope_mark));
     current_level--;
     return current_environment();
 }
 
 
+/* Release the symbols, temporaries and strings of the scope that was just
+   closed. Everything the block installed lies after its environment symbol
+   in sym_table, after its first temporary in temps and, apart from the
+   parameter names, after the scope's mark in the string pool, since each of
+   these tables only grows at the end while the block is open. */
+void symbol_table::reclaim_closed_scope(bool keep_pool)
+{
+    assert(closed_env != NULL_SYM);
+
+    // The parameters were entered first, right after the environment.
+    sym_index keep = closed_env;
+    pool_index pool_mark = closed_mark.pool_pos;
+    while (keep < sym_pos && sym_tags[keep + 1] == SYM_PARAM) {
+        keep++;
+        pool_string view = pool_view(sym_table[keep]->id);
+        pool_index id_end = sym_table[keep]->id +
+                            pool_prefix_size(view.length) + view.length;
+        if (id_end > pool_mark) {
+            pool_mark = id_end;
+        }
+    }
+
+    // Symbols are placed in the arena in the order they are installed, so
+    // the first one dropped is the oldest allocation to release.
+    if (keep < sym_pos) {
+        sym_arena.release(sym_table[keep + 1], sym_pos - keep);
+        for (sym_index i = keep + 1; i <= sym_pos; i++) {
+            sym_table[i] = NULL;
+        }
+        sym_pos = keep;
+    }
+
+    temp_count = closed_mark.temp_count;
+    // A new block may get the same environment index; restart numbering.
+    temp_env = NULL_SYM;
+
+    if (!keep_pool && pool_mark < pool_pos) {
+        pool_rewind(pool_mark);
+    }
+
+    closed_env = NULL_SYM;
+}
+
+
+/* Make a closed block's environment current again, at the level of its
+   body. The levels in between are not restored; nothing looks at them
+   once parsing is done. */
+void symbol_table::resume_scope(sym_index env)
+{
+    resumed_from = current_level;
+    current_level = sym_table[env]->level + 1;
+    resumed_block = block_table[current_level];
+    block_table[current_level] = env;
+}
+
+
+/* Leave the block resume_scope() made current. */
+void symbol_table::leave_resumed_scope()
+{
+    block_table[current_level] = resumed_block;
+    current_level = resumed_from;
+}
+
+
+/* Make a backend space for a block, with room for BACKEND_LABEL_SPACE
+   labels after those of the spaces made before it. The labels are only
+   stand-ins until take_backend_labels(), so label_nr is left as it is. */
+backend_space *symbol_table::new_backend_space(sym_index env)
+{
+    if (space_count >= space_size) {
+        space_size = space_size == 0 ? 16 : 2 * space_size;
+        backend_space **tmp_spaces = new backend_space*[space_size];
+        if (space_count > 0) {
+            memcpy(tmp_spaces, spaces, space_count * sizeof(backend_space *));
+        }
+        delete[] spaces;
+        spaces = tmp_spaces;
+    }
+    if ((space_count + 1) << TEMP_SPACE_SHIFT >= TEMP_SYM_BASE ||
+        label_nr > INT_MAX - (space_count + 1) * BACKEND_LABEL_SPACE) {
+        fatal("Too many blocks to compile in parallel");
+    }
+
+    backend_space *space = new backend_space;
+    space->number = space_count + 1;
+    space->env = env;
+    space->level = sym_table[env]->level + 1;
+    space->next_label = label_nr + space_count * BACKEND_LABEL_SPACE;
+    space->label_end = space->next_label + BACKEND_LABEL_SPACE;
+    space->temp_size = BASE_TEMP_SIZE;
+    space->temp_count = 0;
+    space->temps = new temp_variable[space->temp_size];
+
+    spaces[space_count++] = space;
+    return space;
+}
+
+
+/* Take the labels a space has handed out from the program's numbering.
+   The space's range starts BACKEND_LABEL_SPACE before its end. */
+long symbol_table::take_backend_labels(backend_space *space)
+{
+    long first = space->label_end - BACKEND_LABEL_SPACE;
+    long shift = label_nr - first;
+    label_nr += space->next_label - first;
+    return shift;
+}
+
+
+/* Make the calling thread use a backend space, or none. */
+void symbol_table::use_backend_space(backend_space *space)
+{
+    active_space = space;
+}
+
+
+/* Double the symbol table together with the hot field tables. */
+void symbol_table::sym_grow()
+{
+    sym_index new_size = 2 * sym_size;
+
+    symbol **tmp_table = new symbol*[new_size];
+    sym_type *tmp_tags = new sym_type[new_size];
+    sym_index *tmp_types = new sym_index[new_size];
+    block_level *tmp_levels = new block_level[new_size];
+    int *tmp_offsets = new int[new_size];
+    symbol_detail *tmp_details = new symbol_detail[new_size];
+
+    for (sym_index i = 0; i < new_size; i++) {
+        tmp_table[i] = i < sym_size ? sym_table[i] : NULL;
+    }
+    memcpy(tmp_tags, sym_tags, sym_size * sizeof(sym_type));
+    memcpy(tmp_types, sym_types, sym_size * sizeof(sym_index));
+    memcpy(tmp_levels, sym_levels, sym_size * sizeof(block_level));
+    memcpy(tmp_offsets, sym_offsets, sym_size * sizeof(int));
+    memcpy(tmp_details, sym_details, sym_size * sizeof(symbol_detail));
+
+    delete[] sym_table;
+    delete[] sym_tags;
+    delete[] sym_types;
+    delete[] sym_levels;
+    delete[] sym_offsets;
+    delete[] sym_details;
+
+    sym_table = tmp_table;
+    sym_tags = tmp_tags;
+    sym_types = tmp_types;
+    sym_levels = tmp_levels;
+    sym_offsets = tmp_offsets;
+    sym_details = tmp_details;
+    sym_size = new_size;
+}
+
+
+/* Copy the fields of a symbol into the hot field tables. Apart from the
+   activation record sizes kept up to date by allocate_frame_slot(), this
+   is the only place that writes them, so any change to a symbol's tag,
+   type, level, offset or kind-specific fields must be followed by a call
+   to this. */
+void symbol_table::sync_symbol(const sym_index sym_p)
+{
+    symbol *sym = sym_table[sym_p];
+
+    sym_tags[sym_p] = sym->tag;
+    sym_types[sym_p] = sym->type;
+    sym_levels[sym_p] = sym->level;
+    sym_offsets[sym_p] = sym->offset;
+
+    symbol_detail *detail = &sym_details[sym_p];
+    detail->const_value.ival = 0;
+    switch (sym->tag) {
+    case SYM_PROC: {
+        procedure_symbol *proc = sym->get_procedure_symbol();
+        detail->block.ar_size = proc->ar_size;
+        detail->block.label_nr = proc->label_nr;
+        break;
+    }
+    case SYM_FUNC: {
+        function_symbol *func = sym->get_function_symbol();
+        detail->block.ar_size = func->ar_size;
+        detail->block.label_nr = func->label_nr;
+        break;
+    }
+    case SYM_ARRAY:
+        detail->array_cardinality = sym->get_array_symbol()->array_cardinality;
+        break;
+    case SYM_PARAM:
+        detail->param_size = sym->get_parameter_symbol()->size;
+        break;
+    case SYM_CONST:
+        detail->const_value = sym->get_constant_symbol()->const_value;
+        break;
+    default:
+        break;
+    }
+}
+
+
+
+/* Reserve size bytes at the end of the current environment's activation
+   record and return their offset. The current block can either be a
+   function or a procedure, and we need to differ the two. Fortunately we
+   can use the tag field for this, since it's common to all symbols. */
+int symbol_table::allocate_frame_slot(const int size)
+{
+    sym_index env = current_environment();
+    symbol *tmp = sym_table[env];
+    int offset;
+
+    if (tmp->tag == SYM_FUNC) {
+        function_symbol *cur_func = tmp->get_function_symbol();
+        offset = cur_func->ar_size;
+        cur_func->ar_size += size;
+    } else {
+        procedure_symbol *cur_proc = tmp->get_procedure_symbol();
+        offset = cur_proc->ar_size;
+        cur_proc->ar_size += size;
+    }
+    // Only the size has changed. The other fields are left alone, since
+    // other threads may be reading them; see use_backend_space().
+    sym_details[env].block.ar_size = offset + size;
+
+    return offset;
+}
+
+
+
+/*** Symbol arena methods. ***/
+
+symbol_arena::symbol_arena()
+{
+    chunks = NULL;
+    next_free = NULL;
+    chunk_end = NULL;
+    heap_allocations = 0;
+    objects = 0;
+    bytes_allocated = 0;
+    bytes_used = 0;
+    peak_bytes_allocated = 0;
+}
+
+
+/* The storage of a chunk starts after its header, rounded up so that it
+   stays aligned. */
+char *symbol_arena::storage(chunk *c)
+{
+    const size_t align = alignof(max_align_t);
+    return (char *) c + ((sizeof(chunk) + align - 1) & ~(align - 1));
+}
+
+
+/* Free all chunks. The objects in them are not destructed. */
+symbol_arena::~symbol_arena()
+{
+    while (chunks != NULL) {
+        chunk *next = chunks->next;
+        delete[] (char *) chunks;
+        chunks = next;
+    }
+}
+
+
+/* Bump allocate size bytes. A new chunk is taken from the heap when the
+   current one can't hold the object; whatever is left of the old chunk
+   is wasted, which is fine since symbols are small. */
+void *symbol_arena::allocate(size_t size)
+{
+    const size_t align = alignof(max_align_t);
+    size = (size + align - 1) & ~(align - 1);
+
+    if (next_free == NULL || (size_t) (chunk_end - next_free) < size) {
+        // Round the header up so the storage after it stays aligned.
+        size_t header = (sizeof(chunk) + align - 1) & ~(align - 1);
+        size_t chunk_size = (size_t) SYMBOL_ARENA_CHUNK;
+        if (size > chunk_size - header) {
+            chunk_size = size + header;
+        }
+
+        if (chunks != NULL) {
+            chunks->used = next_free - storage(chunks);
+        }
+        chunk *c = (chunk *) new char[chunk_size];
+        c->next = chunks;
+        c->size = chunk_size;
+        c->used = 0;
+        chunks = c;
+        next_free = (char *) c + header;
+        chunk_end = (char *) c + chunk_size;
+
+        heap_allocations++;
+        bytes_allocated += chunk_size;
+        if (bytes_allocated > peak_bytes_allocated) {
+            peak_bytes_allocated = bytes_allocated;
+        }
+    }
+
+    void *p = next_free;
+    next_free += size;
+    objects++;
+    bytes_used += size;
+    return p;
+}
+
+
+/* Rewind the arena to p, freeing the chunks allocated after the one that
+   holds it. Nothing placed at or after p is destructed. */
+void symbol_arena::release(void *p, long count)
+{
+    char *first = (char *) p;
+
+    // Newer chunks come first in the list.
+    while (first < storage(chunks) || first >= chunk_end) {
+        chunk *c = chunks;
+        bytes_used -= next_free - storage(c);
+        bytes_allocated -= c->size;
+        chunks = c->next;
+        delete[] (char *) c;
+
+        assert(chunks != NULL);
+        next_free = storage(chunks) + chunks->used;
+        chunk_end = (char *) chunks + chunks->size;
+    }
+
+    bytes_used -= next_free - first;
+    next_free = first;
+    objects -= count;
+}
+
+
+
 /*** Main symbol table methods. ***/
 
 /* Return a sym_index to the sought symbol (or NULL_SYM if none was found), given
@@ -604,25 +1469,29 @@ sym_index symbol_table::close_scope()
    follows hash links outwards. */
 sym_index symbol_table::lookup_symbol(const pool_index pool_p)
 {
-    sym_index cur_sym_index = hash_table[hash(pool_p)];
-    if (cur_sym_index == NULL_SYM)
-    {
-        return NULL_SYM;
-    }
-    while (1)
+    pool_string view = pool_view(pool_p);
+    return lookup_symbol(pool_p, (hash_index) string_hash(view.str, view.length));
+}
+
+
+/* The same, given the full hash of the name as well. Names are interned, so
+   a symbol has the name if it has the same pool index; the cached hash in
+   back_link rules out most other symbols in the chain without loading their
+   ids. */
+sym_index symbol_table::lookup_symbol(const pool_index pool_p,
+                                      const hash_index h)
+{
+    sym_index cur_sym_index = hash_table[h & (hash_size - 1)];
+    while (cur_sym_index != NULL_SYM)
     {
-        symbol* current_symbol = get_symbol(cur_sym_index);
-        if (pool_compare(current_symbol->id, pool_p))
+        symbol* current_symbol = sym_table[cur_sym_index];
+        if (current_symbol->back_link == h && current_symbol->id == pool_p)
         {
             return cur_sym_index;
         }
-        else
-        {
-            cur_sym_index = current_symbol->hash_link;
-        }
-        if (cur_sym_index == NULL_SYM) break;
+        cur_sym_index = current_symbol->hash_link;
     }
-    
+
     return NULL_SYM;
 }
 
@@ -631,7 +1500,8 @@ sym_index symbol_table::lookup_symbol(const pool_index pool_p)
 
 symbol *symbol_table::get_symbol(const sym_index sym_p)
 {
-    if (sym_p == NULL_SYM) {
+    // Temporaries have no symbol object.
+    if (sym_p == NULL_SYM || is_temp(sym_p)) {
         return NULL;
     }
 
@@ -657,34 +1527,6 @@ pool_index symbol_table::get_symbol_id(const sym_index sym_p)
 }
 
 
-/* Given a sym_index, we return the type field of the symbol (which is in
-   itself a sym_index to a type symbol). We need to be able to access this
-   information in parser.y, and this is a convenient way to do it. */
-
-sym_index symbol_table::get_symbol_type(const sym_index sym_p)
-{
-    if (sym_p == NULL_SYM) {
-        return void_type;
-    }
-
-    return sym_table[sym_p]->type;
-}
-
-
-/* Given a sym_index, we return the tag field of the symbol. This is a
-   convenience method used in parser.y so we don't need to explicitly handle
-   symbols in it when differing various types of identifiers from one
-   another. */
-sym_type symbol_table::get_symbol_tag(const sym_index sym_p)
-{
-    if (sym_p == NULL_SYM) {
-        return SYM_UNDEF;
-    }
-
-    return sym_table[sym_p]->tag;
-}
-
-
 /* We get a sym_index to a symbol, and a sym_index to a type. We set the
     symbol's type pointer to the second argument. Used to set the correct
     return type for a function. Used in parser.y. */
@@ -697,6 +1539,7 @@ void symbol_table::set_symbol_type(const sym_index sym_p,
     }
 
     sym_table[sym_p]->type = type_p;
+    sync_symbol(sym_p);
 }
 
 
@@ -713,44 +1556,59 @@ sym_index symbol_table::install_symbol(const pool_index pool_p,
                                        const sym_type tag)
 {
  
-    sym_index existing_sym_index = lookup_symbol(pool_p);
+    // The name is hashed once, for the lookup and for back_link.
+    pool_string view = pool_view(pool_p);
+    hash_index h = (hash_index) string_hash(view.str, view.length);
+    sym_index existing_sym_index = lookup_symbol(pool_p, h);
 
     if (existing_sym_index != NULL_SYM && get_symbol(existing_sym_index)->level == current_level)
     {
         return existing_sym_index;
     }
-    symbol* new_symbol;
+    symbol* new_symbol = NULL;
     switch (tag) 
     {
         case SYM_CONST:
-            new_symbol = new constant_symbol(pool_p);
+            new_symbol = sym_arena.create<constant_symbol>(pool_p);
             break;
         case SYM_VAR:
-            new_symbol = new variable_symbol(pool_p);
+            new_symbol = sym_arena.create<variable_symbol>(pool_p);
             break;
         case SYM_ARRAY:
-            new_symbol = new array_symbol(pool_p);
+            new_symbol = sym_arena.create<array_symbol>(pool_p);
             break;
         case SYM_PARAM:
-            new_symbol = new parameter_symbol(pool_p);
+            new_symbol = sym_arena.create<parameter_symbol>(pool_p);
             break;
         case SYM_PROC:
-            new_symbol = new procedure_symbol(pool_p);
+            new_symbol = sym_arena.create<procedure_symbol>(pool_p);
             break;
         case SYM_FUNC:
-            new_symbol = new function_symbol(pool_p);
+            new_symbol = sym_arena.create<function_symbol>(pool_p);
             break;
         case SYM_NAMETYPE:
-            new_symbol = new nametype_symbol(pool_p);
+            new_symbol = sym_arena.create<nametype_symbol>(pool_p);
             break;
         default:
             fatal("Symbol type not defined 😀");
     }
+    new_symbol->type = void_type;
     new_symbol->level = current_level;
     new_symbol->offset = 0;
 
-    hash_index h_index = hash(pool_p);
-    new_symbol->back_link = h_index;
+    // Double the symbol table if it is full.
+    if (sym_pos + 1 >= sym_size) {
+        sym_grow();
+    }
+
+    // Keep the hash chains short by growing the hash table on load.
+    if (scope_log_pos + 1 > MAX_HASH_LOAD * hash_size) {
+        hash_grow();
+    }
+
+    // Cache the full hash of the name; the bucket is its low bits.
+    new_symbol->back_link = h;
+    hash_index h_index = new_symbol->back_link & (hash_size - 1);
     sym_index existing_index = hash_table[h_index];
     if (existing_index != NULL_SYM)
     {
@@ -764,6 +1622,17 @@ sym_index symbol_table::install_symbol(const pool_index pool_p,
     hash_table[h_index] = ++sym_pos;
     sym_table[sym_pos] = new_symbol;
 
+    // Record it in the scope undo log.
+    if (scope_log_pos >= scope_log_size) {
+        sym_index *tmp_log = new sym_index[2 * scope_log_size];
+        memcpy(tmp_log, scope_log, scope_log_size * sizeof(sym_index));
+        delete[] scope_log;
+        scope_log = tmp_log;
+        scope_log_size *= 2;
+    }
+    scope_log[scope_log_pos++] = sym_pos;
+    sync_symbol(sym_pos);
+
     return sym_pos; // Return index to the symbol we just created.
 }
 
@@ -772,7 +1641,7 @@ sym_index symbol_table::install_symbol(const pool_index pool_p,
    This function is used from within parser.y. Currently we call using the
    field data instead of a symbol, since we're not keeping position information
    in the *_symbol classes at the moment. */
-sym_index symbol_table::enter_constant(position_information *pos,
+sym_index symbol_table::enter_constant(position_information pos,
                                        const pool_index pool_p,
                                        const sym_index type,
                                        const long ival)
@@ -794,6 +1663,7 @@ sym_index symbol_table::enter_constant(position_information *pos,
 
     con->const_value.ival = ival;
     sym_table[sym_p] = con;
+    sync_symbol(sym_p);
 
     return sym_p;
 }
@@ -804,7 +1674,7 @@ sym_index symbol_table::enter_constant(position_information *pos,
    This function is used from within parser.y. Currently we call using the
    field data instead of a symbol, since we're not keeping position information
    in the *_symbol classes at the moment. */
-sym_index symbol_table::enter_constant(position_information *pos,
+sym_index symbol_table::enter_constant(position_information pos,
                                        const pool_index pool_p,
                                        const sym_index type,
                                        const double rval)
@@ -832,6 +1702,7 @@ sym_index symbol_table::enter_constant(position_information *pos,
     con->const_value.rval = rval;
 
     sym_table[sym_p] = con;
+    sync_symbol(sym_p);
 
     return sym_p;
 }
@@ -839,7 +1710,7 @@ sym_index symbol_table::enter_constant(position_information *pos,
 
 /* Enter a variable into the symbol table. This function is used from within
    parser.y. */
-sym_index symbol_table::enter_variable(position_information *pos,
+sym_index symbol_table::enter_variable(position_information pos,
                                        const pool_index pool_p,
                                        const sym_index type)
 {
@@ -874,23 +1745,10 @@ sym_index symbol_table::enter_variable(position_information *pos,
     // activation frames. We need to know how many bytes the variable will
     // take up.
 
-    // We re-use tmp for some more casting here. The current block can either
-    // be a function or a procedure, and we need to differ the two. Fortunately
-    // we can use the tag field for this, since it's common to all symbols.
-    tmp = sym_table[current_environment()];
-    if (tmp->tag == SYM_FUNC) {
-        function_symbol *cur_func = tmp->get_function_symbol();
-        var->offset = cur_func->ar_size;
-        cur_func->ar_size += get_size(type);
-        sym_table[current_environment()] = cur_func;
-    } else {
-        procedure_symbol *cur_proc = tmp->get_procedure_symbol();
-        var->offset = cur_proc->ar_size;
-        cur_proc->ar_size += get_size(type);
-        sym_table[current_environment()] = cur_proc;
-    }
+    var->offset = allocate_frame_slot(get_size(type));
 
     sym_table[sym_p] = var;
+    sync_symbol(sym_p);
 
     return sym_p;
 }
@@ -900,7 +1758,7 @@ sym_index symbol_table::enter_variable(position_information *pos,
    Position information is irrelevant in that case. */
 sym_index symbol_table::enter_variable(pool_index pool_p, sym_index type)
 {
-    return enter_variable(NULL, pool_p, type);
+    return enter_variable(position_information(), pool_p, type);
 }
 
 
@@ -908,7 +1766,7 @@ sym_index symbol_table::enter_variable(pool_index pool_p, sym_index type)
    NOTE: We currently assume that parser.y only allows integer index types.
    If that part's changed, we'll need to pass the type of the index as an
    argument to this function as well. */
-sym_index symbol_table::enter_array(position_information *pos,
+sym_index symbol_table::enter_array(position_information pos,
                                     const pool_index pool_p,
                                     const sym_index type,
                                     const int cardinality)
@@ -939,11 +1797,6 @@ sym_index symbol_table::enter_array(position_information *pos,
     // This information is used later on when we allocate memory space on
     // activation frames. We need to know how many bytes the variable will
     // take up, and at what offset to find it.
-    // We do some more casting here. The current block can either
-    // be a function or a procedure, and we need to differ the two. Fortunately
-    // we can use the tag field for this, since it's common to all symbols.
-    symbol* tmp = sym_table[current_environment()];
-
     // We only do this if the array had a legal index. The reason is that the
     // value we use for illegal indexes happens to be -1, and using that value
     // here would mess up the offsets and ar_sizes to no end. The illegal
@@ -952,26 +1805,17 @@ sym_index symbol_table::enter_array(position_information *pos,
     // can't call this method with a float as the last argument, so we take
     // this approach instead.
     if (cardinality != ILLEGAL_ARRAY_CARD) {
-        if (tmp->tag == SYM_FUNC) {
-            function_symbol *cur_func = tmp->get_function_symbol();
-            arr->offset = cur_func->ar_size;
-            cur_func->ar_size += cardinality * get_size(type);
-            sym_table[current_environment()] = cur_func;
-        } else {
-            procedure_symbol *cur_proc = tmp->get_procedure_symbol();
-            arr->offset = cur_proc->ar_size;
-            cur_proc->ar_size += cardinality * get_size(type);
-            sym_table[current_environment()] = cur_proc;
-        }
+        arr->offset = allocate_frame_slot(cardinality * get_size(type));
     }
     sym_table[sym_p] = arr;
+    sync_symbol(sym_p);
 
     return sym_p;
 }
 
 
 /* Enter a function_symbol into the symbol table. */
-sym_index symbol_table::enter_function(position_information *pos,
+sym_index symbol_table::enter_function(position_information pos,
                                        const pool_index pool_p)
 {
     // Install a function_symbol in the symbol table.
@@ -999,13 +1843,14 @@ sym_index symbol_table::enter_function(position_information *pos,
     proc->label_nr = get_next_label();
 
     sym_table[sym_p] = proc;
+    sync_symbol(sym_p);
 
     return sym_p;
 }
 
 
 /* Enter a procedure_symbol into the symbol table. */
-sym_index symbol_table::enter_procedure(position_information *pos,
+sym_index symbol_table::enter_procedure(position_information pos,
                                         const pool_index pool_p)
 {
     sym_index sym_p = install_symbol(pool_p, SYM_PROC);
@@ -1028,13 +1873,14 @@ sym_index symbol_table::enter_procedure(position_information *pos,
     proc->label_nr = get_next_label();
 
     sym_table[sym_p] = proc;
+    sync_symbol(sym_p);
 
     return sym_p;
 }
 
 
 /* Enter a parameter into the symbol table. */
-sym_index symbol_table::enter_parameter(position_information *pos,
+sym_index symbol_table::enter_parameter(position_information pos,
                                         const pool_index pool_p,
                                         const sym_index type)
 {
@@ -1096,6 +1942,7 @@ sym_index symbol_table::enter_parameter(position_information *pos,
     par->type = type;
 
     sym_table[sym_p] = par;
+    sync_symbol(sym_p);
 
     return sym_p;
 }
@@ -1106,7 +1953,7 @@ sym_index symbol_table::enter_parameter(position_information *pos,
    table, but in a language where you can define new types, this function is
    needed. So we prepare Diesel for expanding, even if this function
    currently doesn't do any spectacular things. :) */
-sym_index symbol_table::enter_nametype(position_information *pos,
+sym_index symbol_table::enter_nametype(position_information pos,
                                        const pool_index pool_p)
 {
     // Install a nametype_symbol in the symbol table.
@@ -1120,6 +1967,7 @@ sym_index symbol_table::enter_nametype(position_information *pos,
     // Set up the nametype-specific fields.
     sym_table[sym_p]->tag = SYM_NAMETYPE;
     sym_table[sym_p]->type = void_type;
+    sync_symbol(sym_p);
 
     return sym_p;
 }
@@ -1,6 +1,8 @@
 #ifndef __SYMTAB_HH__
 #define __SYMTAB_HH__
 
+#include <new>
+#include <stddef.h>
 #include "error.hh"
 
 // Set this #define to 0 after the scanner works.
@@ -23,6 +25,54 @@ typedef union {
     double rval;
 } constant_value;
 
+/* Kind-specific fields of a symbol, as kept in the symbol table's side
+   table. Which member is valid depends on the symbol's tag. */
+typedef union {
+    struct {
+        int ar_size;
+        int label_nr;
+    } block;                          // SYM_PROC and SYM_FUNC.
+    int            array_cardinality; // SYM_ARRAY.
+    int            param_size;        // SYM_PARAM.
+    constant_value const_value;       // SYM_CONST.
+} symbol_detail;
+
+/* A temporary variable, as kept in the symbol table's temporary table. */
+typedef struct {
+    sym_index   type;
+    int         offset;
+    block_level level;
+    long        number;   // Counted per function; used for its name.
+} temp_variable;
+
+/* The labels and temporaries of a block whose quads and assembler code are
+   generated on a worker thread. See symbol_table::use_backend_space(). */
+typedef struct {
+    long           number;      // Its place among the spaces, from 1.
+    sym_index      env;         // The block's procedure or function.
+    block_level    level;       // The level of the block's body.
+    long           next_label;
+    long           label_end;   // One past the last label of the space.
+    temp_variable *temps;
+    long           temp_count;
+    long           temp_size;
+} backend_space;
+
+/* How far the symbol table had come when a scope was opened. */
+typedef struct {
+    long       log_pos;    // scope_log_pos.
+    pool_index pool_pos;   // pool_pos.
+    long       temp_count; // temp_count.
+} scope_mark;
+
+/* A non-owning view of a string in the string pool. The characters are NOT
+   null terminated. The pool never moves, so the view stays valid until the
+   string is removed with pool_forget(). */
+typedef struct {
+    const char *str;
+    int         length;
+} pool_string;
+
 /* The various types of symbol tags that can appear. If C++ had had an
    instanceof operator like Java, we wouldn't need this... */
 // enumerated 0-7
@@ -41,24 +91,42 @@ typedef enum symbol_types sym_type;
 /* Some numerical constants we use in the symbol table. */
 
 /*!
- *  Max allowed nesting levels (size of block table).
+ *  Base number of nesting levels (size of block table). Doubled when a
+ *  deeper level is opened.
+ */
+const block_level BASE_BLOCK_SIZE = 8;
+
+/*!
+ *  Base size of hash table. Must be a power of two.
+ */
+const hash_index BASE_HASH_SIZE = 512;
+
+/*!
+ *  Max number of visible symbols per hash bucket, on average, before the
+ *  hash table is doubled and rehashed.
  */
-const block_level MAX_BLOCK = 8;
+const long MAX_HASH_LOAD = 1;
 
 /*!
- *  Max size of hash table.
+ *  Size of each string pool chunk. Must be a power of two. A string too
+ *  long for one chunk gets a contiguous allocation spanning several.
  */
-const hash_index MAX_HASH = 512;
+const pool_index POOL_CHUNK_SIZE = 64 * 1024;
 
 /*!
- *  Base size of string pool.
+ *  Base size of the string pool intern index. Must be a power of two.
  */
-const pool_index BASE_POOL_SIZE = 1024;
+const long BASE_INTERN_SIZE = 256;
 
 /*!
- *  Max size of symbol table.
+ *  Base size of symbol table. Doubled when full.
  */
-const sym_index MAX_SYM = 1024;
+const sym_index BASE_SYM_SIZE = 1024;
+
+/*!
+ *  Size in bytes of each chunk the symbol arena takes from the heap.
+ */
+const long SYMBOL_ARENA_CHUNK = 32 * 1024;
 
 /*!
  *  Signifies 'no symbol'.
@@ -79,6 +147,30 @@ const int ILLEGAL_ARRAY_CARD = -1;
 const int MAX_TEMP_VARS = 999999;
 const int MAX_TEMP_VAR_LENGTH = 8;
 
+/*!
+   Temporaries returned by gen_temp_var() are numbered from this sym_index
+   upwards, far above any real symbol. They have no symbol object and never
+   enter the string pool or the hash table.
+ */
+const sym_index TEMP_SYM_BASE = 1L << 40;
+
+/*!
+   The temporaries of a backend_space are numbered from TEMP_SYM_BASE plus
+   its number shifted up this far, so each space can hold this many bits
+   worth of them.
+ */
+const int TEMP_SPACE_SHIFT = 24;
+
+/*!
+   The number of labels reserved for each backend_space.
+ */
+const long BACKEND_LABEL_SPACE = 1L << 16;
+
+/*!
+   Base size of the temporary variable table.
+ */
+const long BASE_TEMP_SIZE = 256;
+
 /* The various symbol classes, predefined. */
 class constant_symbol;
 class variable_symbol;
@@ -138,7 +230,7 @@ protected:
 
     typedef enum format_types format_type;
 
-    static format_type output_format;
+    static thread_local format_type output_format;
 
 public:
     /*! \brief Index to the string_pool, ie, its name.
@@ -184,7 +276,9 @@ public:
     /*!
      This link points back to the hash table from the symbol table and
      can be used to speed up certain types of lookups.
-     It is possible to complete the lab without using it, though.
+     It holds the full hash value of the symbol's name, computed once by
+     install_symbol(); the bucket is found by masking it with the hash table
+     size. This way neither close_scope() nor rehashing touches the name.
      */
     hash_index back_link;
 
@@ -500,6 +594,82 @@ ostream &long_symbols(ostream &);
 /* Allow a node to be sent to an outstream for printing. */
 ostream &operator<<(ostream &, symbol *);
 
+/* Wraps a sym_index so it can be sent to an outstream. It prints like the
+   symbol itself would, but also works for temporaries, which have no
+   symbol object. */
+struct sym_ref {
+    sym_index sym;
+    explicit sym_ref(sym_index s) : sym(s) {}
+};
+
+ostream &operator<<(ostream &, const sym_ref &);
+
+
+
+/*******************************
+ *** THE SYMBOL ARENA CLASS  ***
+ *******************************/
+
+/*!
+ Bump allocator owned by the symbol table. Symbols are placed back to back
+ in large chunks instead of being allocated one by one, and all chunks are
+ freed at once when the arena is destroyed. Destructors of the placed
+ symbols are never run; symbols own no other memory.
+ */
+class symbol_arena
+{
+private:
+    // Header of a chunk. The chunk's storage follows it directly. used is
+    // only kept up to date once the arena has moved on to a newer chunk.
+    struct chunk {
+        chunk *next;
+        long   size;
+        long   used;
+    };
+
+    // Start of a chunk's storage.
+    static char *storage(chunk *);
+
+    // Most recently allocated chunk, linked to the older ones.
+    chunk *chunks;
+
+    // Next free byte in the current chunk, and its end.
+    char *next_free;
+    char *chunk_end;
+
+public:
+    // Number of chunks taken from the heap.
+    long heap_allocations;
+
+    // Number of objects placed in the arena.
+    long objects;
+
+    // Bytes taken from the heap, and bytes handed out to objects.
+    long bytes_allocated;
+    long bytes_used;
+
+    // Largest value bytes_allocated has had.
+    long peak_bytes_allocated;
+
+    symbol_arena();
+    ~symbol_arena();
+
+    //! Returns suitably aligned storage for an object of the given size.
+    void *allocate(size_t);
+
+    //! Places a new symbol of class T with the given identifier.
+    template <class T> T *create(const pool_index pool_p) {
+        return new (allocate(sizeof(T))) T(pool_p);
+    }
+
+    /*!
+     Gives back the object at the given address and every object placed
+     after it, which must be count objects in all. Chunks that become
+     empty are returned to the heap.
+     */
+    void release(void *, long);
+};
+
 
 
 
@@ -528,19 +698,103 @@ class symbol_table
 private:
     // --- String pool variables. ---
 
-    char *string_pool; /*!< \brief The actual string pool. */
+    /*!
+     \brief The actual string pool, as a table of chunks.
+
+     The byte at pool_index p lives in chunk slot p / ``POOL_CHUNK_SIZE``.
+     Chunks are never moved or copied when the pool grows. An entry always
+     lies within one allocation: if it does not fit in what is left of the
+     current chunk, the rest of the chunk is marked unused and the entry
+     starts a new one.
+     */
+    char **pool_chunks;
+
+    // True for the chunk slots that start a separate allocation.
+    bool *pool_chunk_owned;
 
-    // Keep track of dynamic pool size.
-    long pool_length;
+    // Number of chunk slots in use, and room in the slot tables.
+    long pool_chunk_count;
+    long pool_chunk_cap;
 
     // Points to end of string pool
     long pool_pos;
 
+    // Returns the address of a position in the pool.
+    char *pool_address(const pool_index p) {
+        return pool_chunks[p / POOL_CHUNK_SIZE] + (p & (POOL_CHUNK_SIZE - 1));
+    }
+
+    // Allocates a contiguous chunk covering the given number of slots.
+    void pool_add_chunk(long);
+
+    // Makes room for an entry of the given size at pool_pos.
+    char *pool_reserve(long);
+
+    // Upper cases (and unquotes) a token while installing it.
+    pool_index pool_install_folded(const char *, int, bool);
+
+    // --- String intern index variables. ---
+
+    /*!
+     * Open addressing hash table over the string pool, keyed on string
+     * contents. Each slot holds the pool_index of an installed string,
+     * or NULL_SYM if the slot is free. Lets pool_install() find an
+     * already installed string without walking the whole pool.
+     */
+    pool_index *intern_table;
+
+    // Number of slots in intern_table. Always a power of two.
+    long intern_size;
+
+    // Number of occupied slots in intern_table.
+    long intern_count;
+
+    // Hashes a string of the given length. Used both for the intern
+    // index and the symbol hash table.
+    unsigned long string_hash(const char *, int);
+
+    // Returns the intern_table slot holding the string, or the free slot
+    // where it would be inserted.
+    long intern_slot(const char *, int);
+    long intern_slot(const char *, int, unsigned long);
+
+    // lookup_symbol() for a name whose full hash is already known.
+    sym_index lookup_symbol(const pool_index, const hash_index);
+
+    // Doubles intern_table and reinserts all entries.
+    void intern_grow();
+
+    // Removes a pool_index from intern_table. Used by pool_forget().
+    void intern_remove(const pool_index);
+
+    // Removes every string from the given pool_index on, and frees the
+    // chunks they leave empty.
+    void pool_rewind(const pool_index);
+
     // --- Hash table variables. ---
 
     // The actual hash table.
     sym_index *hash_table;
 
+    // Number of buckets in hash_table. Always a power of two.
+    hash_index hash_size;
+
+    // Doubles hash_table and relinks all visible symbols.
+    void hash_grow();
+
+    // --- Scope undo log. ---
+
+    /*
+     * Every symbol linked into hash_table, in the order it was linked.
+     * close_scope() pops the entries of the closing scope off the end and
+     * unlinks them, which costs O(symbols in scope). Since chains are kept
+     * newest first, each popped symbol is at the head of its bucket.
+     * scope_log_pos is thus also the number of visible symbols.
+     */
+    sym_index *scope_log;
+    long scope_log_pos;
+    long scope_log_size;
+
     // --- Display variables. ---
 
     block_level current_level; /*!< \brief Current nesting depth. */
@@ -551,11 +805,86 @@ private:
      */
     sym_index *block_table;
 
+    // Number of entries in block_table.
+    block_level block_size;
+
+    // For each open level, where the tables stood when it was opened.
+    scope_mark *scope_marks;
+
+    // Environment and mark of the scope close_scope() closed last, for
+    // reclaim_closed_scope(). closed_env is NULL_SYM when there is none.
+    sym_index closed_env;
+    scope_mark closed_mark;
+
+    // The level that was current before resume_scope(), and the block
+    // that resume_scope() replaced in block_table.
+    block_level resumed_from;
+    sym_index resumed_block;
+
     // --- Symbol table variables. ---
 
+    // Storage for the symbols themselves.
+    symbol_arena sym_arena;
+
     // The actual symbol table.
     symbol **sym_table;
 
+    // Number of entries in sym_table.
+    sym_index sym_size;
+
+    // Doubles sym_table and the hot field tables.
+    void sym_grow();
+
+    // --- Hot field tables. ---
+
+    /*
+     * Struct-of-arrays copies of the symbol fields read on every fetch,
+     * store and find, indexed by sym_index and sized like sym_table.
+     * Reading these avoids chasing the symbol pointer and the virtual
+     * get_*_symbol() downcasts. The symbol objects stay authoritative;
+     * every method that changes one calls sync_symbol() afterwards.
+     */
+    sym_type      *sym_tags;
+    sym_index     *sym_types;
+    block_level   *sym_levels;
+    int           *sym_offsets;
+    symbol_detail *sym_details;
+
+    // Copies a symbol's fields into the hot field tables.
+    void sync_symbol(const sym_index);
+
+    // Reserves bytes in the current environment's activation record and
+    // returns their offset.
+    int allocate_frame_slot(const int);
+
+    // --- Temporary variable table. ---
+
+    /*
+     * Temporaries are typed virtual registers: sym_index
+     * TEMP_SYM_BASE + i is described by temps[i]. They are numbered from 1
+     * in each function; temp_env is the environment that temp_nr is
+     * currently counting for.
+     */
+    temp_variable *temps;
+    long temp_count;
+    long temp_size;
+    sym_index temp_env;
+
+    // The spaces made by new_backend_space(), indexed by number - 1.
+    backend_space **spaces;
+    long space_count;
+    long space_size;
+
+    // The temporary that a sym_index returned by gen_temp_var() stands for.
+    temp_variable &get_temp(const sym_index sym_p) {
+        long i = sym_p - TEMP_SYM_BASE;
+        if (i >> TEMP_SPACE_SHIFT) {
+            return spaces[(i >> TEMP_SPACE_SHIFT) - 1]->
+                temps[i & ((1L << TEMP_SPACE_SHIFT) - 1)];
+        }
+        return temps[i];
+    }
+
     // Points to last symbol entered in the table.
     sym_index sym_pos;
 
@@ -570,6 +899,9 @@ public:
 
     symbol_table();
 
+    // Frees the tables, the string pool and all symbols.
+    ~symbol_table();
+
     // --- Utility methods. ---
 
     // Convert a double to ieee 64-bit represented as a long
@@ -581,6 +913,7 @@ public:
     // --- String pool methods. ---
     /*!
     * Finds existing entry of character in string pool, used for shared strings.
+    * Looks the string up in the intern index, so this is expected O(1).
     */
     pool_index find_existing_entry(char *);
 
@@ -590,17 +923,37 @@ public:
      */
     pool_index pool_install(char *);
 
+    /*!
+     Install an identifier of the given length, as scanned, in the string
+     pool. It is upper cased on the way in. Does not allocate, and unlike
+     pool_install() the text need not be null terminated.
+     */
+    pool_index pool_install_identifier(const char *, int);
+
+    /*!
+     Install a string constant of the given length, as scanned with its
+     quotes, in the string pool. It is upper cased, its quotes are stripped
+     and doubled quotes are compacted on the way in. Does not allocate.
+     */
+    pool_index pool_install_string_constant(const char *, int);
+
     /*!
      Given a ``::pool_index`` into the string pool, returns the string it
      points to.
      */
     char *pool_lookup(const pool_index);
 
+    /*!
+     Given a ``::pool_index`` into the string pool, returns a view of the
+     string it points to. Unlike pool_lookup(), this does not allocate.
+     */
+    pool_string pool_view(const pool_index);
+
     /*!
      Compare two strings taking their respective ``::pool_index`` as arguments.
-     Returns true if they are identical, and false otherwise. Note that
-     it is not enough to just check that the indices are identical. Why
-     not?
+     Returns true if they are identical, and false otherwise. Since installed
+     strings are shared, identical indices is a fast path; otherwise the
+     pool contents are compared without allocating.
      */
     bool pool_compare(const pool_index, const pool_index);
 
@@ -610,6 +963,9 @@ public:
      */
     pool_index pool_forget(const pool_index);
 
+    //! Returns the number of bytes in use in the string pool.
+    long pool_size() { return pool_pos; }
+
     /*! \brief Remove double ``''`` in strings constants.
 
       Internalizes a string constant. You hopefully use this method in
@@ -663,7 +1019,7 @@ public:
       ``symbol_table#current_level`` (which is currently zero).
 
       Note that the first argument to ``symbol_table::install_symbol`` is an index to
-      the string table (``symbol_table#string_pool``). This is, of course, what the
+      the string table (``symbol_table#pool_chunks``). This is, of course, what the
       scanner outputs in the ``YYSTYPE::pool_p`` field of the ``::yylval`` union. If
       you had problems understanding what it was for earlier, hopefully
       some of that has become more clear now!
@@ -695,7 +1051,8 @@ public:
         Print (only) the string table, showing the current pool_pos.
 
      3
-        Print (only) the non-zero elements in the hash table.
+        Print (only) the non-empty buckets in the hash table with their
+        chain lengths, followed by load factor and chain length statistics.
 
      any other
         Print detailed information about every symbol in the symbol table.
@@ -704,6 +1061,9 @@ public:
      */
     void  print(int);
 
+    //! Prints memory and allocation statistics for the symbol table.
+    void  print_statistics();
+
     //! Given a symbol table index, return its pool_index, or 0 (zero) if no such symbol existed.
     pool_index get_symbol_id(const sym_index);
 
@@ -712,14 +1072,76 @@ public:
      ``::integer_type``, or ``::real_type``).
      If the symbol didn’t exist, returns ``::void_type``.
      */
-    sym_index get_symbol_type(const sym_index);
+    sym_index get_symbol_type(const sym_index sym_p) {
+        if (sym_p == NULL_SYM) {
+            return void_type;
+        }
+        if (is_temp(sym_p)) {
+            return get_temp(sym_p).type;
+        }
+        return sym_types[sym_p];
+    }
 
     /*!
      Given a symbol table index, returns its tag type
      (i.e., the tag marking which symbol class it is:
      ``::SYM_CONST``, ``::SYM_VAR``).
+     If the symbol didn’t exist, returns ``::SYM_UNDEF``.
      */
-    sym_type get_symbol_tag(const sym_index);
+    sym_type get_symbol_tag(const sym_index sym_p) {
+        if (sym_p == NULL_SYM) {
+            return SYM_UNDEF;
+        }
+        // Temporaries live in the frame just like local variables.
+        if (is_temp(sym_p)) {
+            return SYM_VAR;
+        }
+        return sym_tags[sym_p];
+    }
+
+    /*!
+     The accessors below read the hot field tables directly and expect a
+     valid symbol table index. The kind-specific ones expect a symbol of
+     the matching tag.
+     */
+    block_level get_symbol_level(const sym_index sym_p) {
+        if (is_temp(sym_p)) {
+            return get_temp(sym_p).level;
+        }
+        return sym_levels[sym_p];
+    }
+
+    int get_symbol_offset(const sym_index sym_p) {
+        if (is_temp(sym_p)) {
+            return get_temp(sym_p).offset;
+        }
+        return sym_offsets[sym_p];
+    }
+
+    //! Activation record size of a ``::SYM_PROC`` or ``::SYM_FUNC``.
+    int get_ar_size(const sym_index sym_p) {
+        return sym_details[sym_p].block.ar_size;
+    }
+
+    //! Assembler label of a ``::SYM_PROC`` or ``::SYM_FUNC``.
+    int get_label_nr(const sym_index sym_p) {
+        return sym_details[sym_p].block.label_nr;
+    }
+
+    //! Cardinality of a ``::SYM_ARRAY``.
+    int get_array_cardinality(const sym_index sym_p) {
+        return sym_details[sym_p].array_cardinality;
+    }
+
+    //! Byte size of a ``::SYM_PARAM``.
+    int get_param_size(const sym_index sym_p) {
+        return sym_details[sym_p].param_size;
+    }
+
+    //! Value of a ``::SYM_CONST``.
+    constant_value get_const_value(const sym_index sym_p) {
+        return sym_details[sym_p].const_value;
+    }
 
     /*!
     Given a symbol table index to a symbol, and a symbol table index to a type (e.g. ``::integer_type`` etc.),
@@ -734,9 +1156,14 @@ public:
 
     /*!
      Given a symbol table index to a type (e.g., ``::integer_type`` etc.),
-     generates, installs and returns index to a temporary variable of that type.
+     generates and returns index to a temporary variable of that type.
      It is not meaningful to generate a temporary variable of ``::void_type``.
 
+     Temporaries are not installed as symbols. They are kept in a side
+     table, numbered per function, and get a slot in the activation record
+     like local variables do. Use is_temp() to tell them apart; get_symbol()
+     returns NULL for them.
+
      Choose a method for giving the temporary variables names which can
      not collide with the user.
 
@@ -758,6 +1185,48 @@ public:
      */
     sym_index gen_temp_var(sym_index);
 
+    /*! \brief Reserves labels and a temporary table for a block.
+
+     Quads and assembler code for several blocks can be generated at the
+     same time on different threads, once the whole program has been
+     parsed and type checked. Each block then needs a space of its own,
+     made by this method on the main thread before the threads start.
+     The space's labels are stand-ins, set apart from those of the other
+     spaces so that no two threads hand out the same one. They are given
+     their real numbers by take_backend_labels() afterwards, so the
+     numbering does not depend on which thread gets to a block first.
+     \param env the procedure or function symbol of the block.
+     */
+    backend_space *new_backend_space(sym_index env);
+
+    /*! \brief Takes the labels handed out by a space from the program's numbering.
+
+     Takes as many labels as the space has handed out, and returns how
+     much to add to each of them to get the label taken in its place. Done
+     for the blocks in order, the labels are then the ones they would have
+     got if they had been compiled one after another on the main thread.
+     */
+    long take_backend_labels(backend_space *);
+
+    /*! \brief Makes the calling thread generate labels and temporaries in a space.
+
+     While a space is in use, get_next_label() and gen_temp_var() take
+     their labels and temporaries from it, and the space's block is the
+     current environment. Nothing else may change the symbol table until
+     all threads are done. Pass NULL to stop using the space.
+     */
+    void use_backend_space(backend_space *);
+
+    //! True if the index is a temporary returned by gen_temp_var().
+    bool is_temp(const sym_index sym_p) {
+        return sym_p >= TEMP_SYM_BASE;
+    }
+
+    //! The per-function number of a temporary, as in its name ``$N``.
+    long get_temp_number(const sym_index sym_p) {
+        return get_temp(sym_p).number;
+    }
+
     // These functions are used to enter identifiers into the symbol table,
     // depending on their context (function, constant, etc).
 
@@ -766,7 +1235,7 @@ public:
     a ``::sym_index`` to the desired type and an int representing the actual constant value,
     generate and install a constant of the desired type.
     */
-    sym_index enter_constant(position_information *,
+    sym_index enter_constant(position_information,
                              const pool_index,
                              const sym_index,
                              const long);
@@ -776,7 +1245,7 @@ public:
     a ``::sym_index`` to the desired type and an int representing the actual constant value,
     generate and install a constant of the desired type.
     */
-    sym_index enter_constant(position_information *,
+    sym_index enter_constant(position_information,
                              const pool_index,
                              const sym_index,
                              const double);
@@ -786,7 +1255,7 @@ public:
      and a sym_index to the desired type, generate and install a variable
      of the desired type.
      */
-    sym_index enter_variable(position_information *,
+    sym_index enter_variable(position_information,
                              const pool_index,
                              const sym_index);
 
@@ -801,7 +1270,7 @@ public:
      a ``::sym_index`` to the desired type, and an array cardinality,
      generate and install an array of the desired type.
      */
-    sym_index enter_array(position_information *,
+    sym_index enter_array(position_information,
                           const pool_index,
                           const sym_index,
                           const int);
@@ -812,20 +1281,20 @@ public:
 
      The type is set later on since it will not be known at symbol install time.
      */
-    sym_index enter_function(position_information *, const pool_index);
+    sym_index enter_function(position_information, const pool_index);
 
     /*!
      Given position information, and a ``::pool_index`` to an identifier’s name,
      generate and install a procedure.
      */
-    sym_index enter_procedure(position_information *, const pool_index);
+    sym_index enter_procedure(position_information, const pool_index);
 
     /*!
      Given position information, a ``::pool_index`` to an identifier’s name,
      and a sym_index to the desired type, generate and install a parameter
      of the desired type.
      */
-    sym_index enter_parameter(position_information *,
+    sym_index enter_parameter(position_information,
                               const pool_index,
                               const sym_index);
 
@@ -839,7 +1308,7 @@ public:
 
      NOTE: Should perhaps be marked private?
      */
-    sym_index enter_nametype(position_information *, const pool_index);
+    sym_index enter_nametype(position_information, const pool_index);
 
     // --- Display methods. ---
 
@@ -878,6 +1347,36 @@ public:
      the following program code can not reference them.
     */
     sym_index close_scope();
+
+    /*! \brief Frees what the scope that was just closed left behind.
+
+     Optional; the parser calls this right after close_scope() once the
+     block's quads and assembler have been generated, if asked to. The
+     local symbols, temporaries and nested subprograms of the closed block
+     are released and the symbol table is truncated after the block's
+     procedure or function symbol and its parameters, which stay since
+     later calls are checked against them. Unless keep_pool is set, the
+     strings first installed within the block are removed from the string
+     pool as well; the caller must set it if any string index scanned
+     inside the block is still in use (such as a lookahead token). Memory
+     use is then bounded by the nesting depth rather than by the size of
+     the program.
+    */
+    void reclaim_closed_scope(bool keep_pool);
+
+    /*! \brief Makes the scope of a closed block current again.
+
+     Used to compile a block after the whole program has been parsed. The
+     block's procedure or function becomes the current environment, at the
+     level its body had, so that return statements are checked against it
+     and temporaries are placed in its activation record. None of its
+     symbols become visible to lookups again; they were all looked up
+     while parsing. Call leave_resumed_scope() when done.
+    */
+    void resume_scope(sym_index env);
+
+    //! Returns to the level that was current before resume_scope().
+    void leave_resumed_scope();
 };
 
 
@@ -0,0 +1,269 @@
+#ifndef __VISITOR_HH__
+#define __VISITOR_HH__
+
+#include "ast.hh"
+
+
+/*** This class is the base of all passes over the AST: type checking,
+     optimization and quad generation. A pass derives from it, naming
+     itself as the first template argument, and defines a visit_ method
+     for each kind of node it handles. visit() looks at the tag of a node
+     and calls the pass' method for it directly, without any virtual call,
+     so the compiler is free to inline it.
+
+     A pass only has to define the methods it needs. The ones it leaves
+     out fall back on the method for the class the node derives from, see
+     the diagram in ast.hh: visit_add() calls visit_binaryoperation(),
+     which calls visit_expression(), which calls visit_node(). By default
+     visit_node() aborts the compiler, since the pass then has no idea what
+     to do with the node. ***/
+
+
+/* The dispatch is inlined into every place that visits a node, so that
+   visiting a node costs a jump on its tag and a direct call, even in an
+   unoptimized build. */
+#if defined(__GNUC__)
+#define VISIT_INLINE inline __attribute__((always_inline))
+#else
+#define VISIT_INLINE inline
+#endif
+
+
+template <class pass, class result = void>
+class ast_visitor
+{
+private:
+    VISIT_INLINE pass *self() {
+        return static_cast<pass *>(this);
+    }
+
+public:
+    //! Visit a node with the method for its kind.
+    VISIT_INLINE result visit(ast_node *node) {
+        switch (node->tag) {
+        case AST_STMT_LIST:
+            return self()->visit_stmt_list(static_cast<ast_stmt_list *>(node));
+        case AST_EXPR_LIST:
+            return self()->visit_expr_list(static_cast<ast_expr_list *>(node));
+        case AST_ELSIF_LIST:
+            return self()->visit_elsif_list(static_cast<ast_elsif_list *>(node));
+        case AST_ELSIF:
+            return self()->visit_elsif(static_cast<ast_elsif *>(node));
+        case AST_FUNCTIONHEAD:
+            return self()->visit_functionhead(static_cast<ast_functionhead *>(node));
+        case AST_PROCEDUREHEAD:
+            return self()->visit_procedurehead(static_cast<ast_procedurehead *>(node));
+        case AST_PROCEDURECALL:
+            return self()->visit_procedurecall(static_cast<ast_procedurecall *>(node));
+        case AST_ASSIGN:
+            return self()->visit_assign(static_cast<ast_assign *>(node));
+        case AST_WHILE:
+            return self()->visit_while(static_cast<ast_while *>(node));
+        case AST_IF:
+            return self()->visit_if(static_cast<ast_if *>(node));
+        case AST_RETURN:
+            return self()->visit_return(static_cast<ast_return *>(node));
+        case AST_ID:
+            return self()->visit_id(static_cast<ast_id *>(node));
+        case AST_INDEXED:
+            return self()->visit_indexed(static_cast<ast_indexed *>(node));
+        case AST_EQUAL:
+            return self()->visit_equal(static_cast<ast_equal *>(node));
+        case AST_NOTEQUAL:
+            return self()->visit_notequal(static_cast<ast_notequal *>(node));
+        case AST_LESSTHAN:
+            return self()->visit_lessthan(static_cast<ast_lessthan *>(node));
+        case AST_GREATERTHAN:
+            return self()->visit_greaterthan(static_cast<ast_greaterthan *>(node));
+        case AST_ADD:
+            return self()->visit_add(static_cast<ast_add *>(node));
+        case AST_SUB:
+            return self()->visit_sub(static_cast<ast_sub *>(node));
+        case AST_OR:
+            return self()->visit_or(static_cast<ast_or *>(node));
+        case AST_AND:
+            return self()->visit_and(static_cast<ast_and *>(node));
+        case AST_MULT:
+            return self()->visit_mult(static_cast<ast_mult *>(node));
+        case AST_DIVIDE:
+            return self()->visit_divide(static_cast<ast_divide *>(node));
+        case AST_IDIV:
+            return self()->visit_idiv(static_cast<ast_idiv *>(node));
+        case AST_MOD:
+            return self()->visit_mod(static_cast<ast_mod *>(node));
+        case AST_FUNCTIONCALL:
+            return self()->visit_functioncall(static_cast<ast_functioncall *>(node));
+        case AST_UMINUS:
+            return self()->visit_uminus(static_cast<ast_uminus *>(node));
+        case AST_NOT:
+            return self()->visit_not(static_cast<ast_not *>(node));
+        case AST_INTEGER:
+            return self()->visit_integer(static_cast<ast_integer *>(node));
+        case AST_REAL:
+            return self()->visit_real(static_cast<ast_real *>(node));
+        case AST_CAST:
+            return self()->visit_cast(static_cast<ast_cast *>(node));
+        default:
+            // Only the abstract classes have other tags.
+            return self()->visit_node(node);
+        }
+    }
+
+    /*! Called for nodes the pass has no method for. It's an error to get
+      here, unless the pass overrides this method. */
+    result visit_node(ast_node *) {
+        fatal("No visit method for this kind of AST node.");
+        return result();
+    }
+
+    // The abstract classes. See the diagram in ast.hh.
+    VISIT_INLINE result visit_statement(ast_statement *node) {
+        return self()->visit_node(node);
+    }
+
+    VISIT_INLINE result visit_expression(ast_expression *node) {
+        return self()->visit_node(node);
+    }
+
+    VISIT_INLINE result visit_lvalue(ast_lvalue *node) {
+        return self()->visit_expression(node);
+    }
+
+    VISIT_INLINE result visit_binaryrelation(ast_binaryrelation *node) {
+        return self()->visit_expression(node);
+    }
+
+    VISIT_INLINE result visit_binaryoperation(ast_binaryoperation *node) {
+        return self()->visit_expression(node);
+    }
+
+    // Classes derived from ast_node.
+    VISIT_INLINE result visit_stmt_list(ast_stmt_list *node) {
+        return self()->visit_node(node);
+    }
+
+    VISIT_INLINE result visit_expr_list(ast_expr_list *node) {
+        return self()->visit_node(node);
+    }
+
+    VISIT_INLINE result visit_elsif_list(ast_elsif_list *node) {
+        return self()->visit_node(node);
+    }
+
+    VISIT_INLINE result visit_elsif(ast_elsif *node) {
+        return self()->visit_node(node);
+    }
+
+    VISIT_INLINE result visit_functionhead(ast_functionhead *node) {
+        return self()->visit_node(node);
+    }
+
+    VISIT_INLINE result visit_procedurehead(ast_procedurehead *node) {
+        return self()->visit_node(node);
+    }
+
+    // Classes derived from ast_statement.
+    VISIT_INLINE result visit_procedurecall(ast_procedurecall *node) {
+        return self()->visit_statement(node);
+    }
+
+    VISIT_INLINE result visit_assign(ast_assign *node) {
+        return self()->visit_statement(node);
+    }
+
+    VISIT_INLINE result visit_while(ast_while *node) {
+        return self()->visit_statement(node);
+    }
+
+    VISIT_INLINE result visit_if(ast_if *node) {
+        return self()->visit_statement(node);
+    }
+
+    VISIT_INLINE result visit_return(ast_return *node) {
+        return self()->visit_statement(node);
+    }
+
+    // Classes derived from ast_expression.
+    VISIT_INLINE result visit_id(ast_id *node) {
+        return self()->visit_lvalue(node);
+    }
+
+    VISIT_INLINE result visit_indexed(ast_indexed *node) {
+        return self()->visit_lvalue(node);
+    }
+
+    VISIT_INLINE result visit_equal(ast_equal *node) {
+        return self()->visit_binaryrelation(node);
+    }
+
+    VISIT_INLINE result visit_notequal(ast_notequal *node) {
+        return self()->visit_binaryrelation(node);
+    }
+
+    VISIT_INLINE result visit_lessthan(ast_lessthan *node) {
+        return self()->visit_binaryrelation(node);
+    }
+
+    VISIT_INLINE result visit_greaterthan(ast_greaterthan *node) {
+        return self()->visit_binaryrelation(node);
+    }
+
+    VISIT_INLINE result visit_add(ast_add *node) {
+        return self()->visit_binaryoperation(node);
+    }
+
+    VISIT_INLINE result visit_sub(ast_sub *node) {
+        return self()->visit_binaryoperation(node);
+    }
+
+    VISIT_INLINE result visit_or(ast_or *node) {
+        return self()->visit_binaryoperation(node);
+    }
+
+    VISIT_INLINE result visit_and(ast_and *node) {
+        return self()->visit_binaryoperation(node);
+    }
+
+    VISIT_INLINE result visit_mult(ast_mult *node) {
+        return self()->visit_binaryoperation(node);
+    }
+
+    VISIT_INLINE result visit_divide(ast_divide *node) {
+        return self()->visit_binaryoperation(node);
+    }
+
+    VISIT_INLINE result visit_idiv(ast_idiv *node) {
+        return self()->visit_binaryoperation(node);
+    }
+
+    VISIT_INLINE result visit_mod(ast_mod *node) {
+        return self()->visit_binaryoperation(node);
+    }
+
+    VISIT_INLINE result visit_functioncall(ast_functioncall *node) {
+        return self()->visit_expression(node);
+    }
+
+    VISIT_INLINE result visit_uminus(ast_uminus *node) {
+        return self()->visit_expression(node);
+    }
+
+    VISIT_INLINE result visit_not(ast_not *node) {
+        return self()->visit_expression(node);
+    }
+
+    VISIT_INLINE result visit_integer(ast_integer *node) {
+        return self()->visit_expression(node);
+    }
+
+    VISIT_INLINE result visit_real(ast_real *node) {
+        return self()->visit_expression(node);
+    }
+
+    VISIT_INLINE result visit_cast(ast_cast *node) {
+        return self()->visit_expression(node);
+    }
+};
+
+
+#endif
@@ -1,7 +1,12 @@
 #include <iostream>
 #include <iomanip>
+#include <chrono>
+#include <new>
+#include <string>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include "symtab.hh"
 #include "scanner.hh"
 
@@ -91,28 +96,28 @@ ostream &print_token(ostream &o, int token)
             if (i == 40) {
                 re = yylval.rval;
                 o << tokens[i].name << " \'" << yytext << "\' "
-                  << "(" << yylloc.first_line << ", " << yylloc.first_column
+                  << "(" << yylloc.get_line() << ", " << yylloc.get_column()
                   << ")" << " <yylval.rval = " << re << ">";
                 return o;
             } else if (i == 37) {
                 in = yylval.ival;
                 o << tokens[i].name << " \'" << yytext << "\' "
-                  << "(" << yylloc.first_line << ", " << yylloc.first_column
+                  << "(" << yylloc.get_line() << ", " << yylloc.get_column()
                   << ")" << " <yylval.ival = " << in << ">";
                 return o;
             } else if (i == 43) {
                 o << tokens[i].name << " \'" << yytext << "\' "
-                  << "(" << yylloc.first_line << ", " << yylloc.first_column
+                  << "(" << yylloc.get_line() << ", " << yylloc.get_column()
                   << ")" << " <yylval.str = " << sym_tab->capitalize(sym_tab->pool_lookup(yylval.str)) << ">";
                 return o;
             } else if (i == 31) {
                 o << tokens[i].name << " \'" << yytext << "\' "
-                  << "(" << yylloc.first_line << ", " << yylloc.first_column
+                  << "(" << yylloc.get_line() << ", " << yylloc.get_column()
                   << ")" << " <yylval.pool_p = " << sym_tab->pool_lookup(yylval.pool_p) << ">";
                 return o;
             } else {
                 o << tokens[i].name << " \'" << yytext << "\' "
-                  << "(" << yylloc.first_line << ", " << yylloc.first_column
+                  << "(" << yylloc.get_line() << ", " << yylloc.get_column()
                   << ")";
                 return o;
             } //sym_tab->capitalize(sym_tab->pool_lookup(yylval.str))
@@ -151,14 +156,165 @@ const Omanip_int Token(int t)
 /* Magic part ends here. */
 
 
+/*** Benchmark mode. ***/
+
+/* With -b, the scanner is run over synthetic inputs of about the given
+   size instead of a file, one for each kind of token that dominates the
+   scanning time of real programs. Each prints one line of
+   comma-separated values:
+
+     benchmark,bytes,tokens,mb_per_s,tokens_per_s,pool_bytes,allocs
+
+   The time is that of the yylex() loop only; the input is written to a
+   temporary file first and scanned in place like the compiler does.
+   pool_bytes is what the string pool grew by, and allocs counts calls to
+   operator new, both during the loop. */
+
+static long heap_allocations = 0;
+
+void *operator new(size_t size)
+{
+    void *p = malloc(size);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    heap_allocations++;
+    return p;
+}
+
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+
+/* Many distinct identifiers mixed with a small set of repeated ones, as
+   in declarations and assignments. */
+static void make_identifiers(string &text, long i)
+{
+    char line[128];
+    snprintf(line, sizeof(line),
+             "variable_%ld := counter_%ld + Total * index_value;\n",
+             i, i % 64);
+    text += line;
+}
+
+
+/* String constants, some with doubled quotes. */
+static void make_strings(string &text, long i)
+{
+    char line[128];
+    snprintf(line, sizeof(line),
+             "write('Line %ld of the output, isn''t it?', 'x%ld');\n",
+             i, i % 16);
+    text += line;
+}
+
+
+/* Comments of all three kinds, with little code between them. */
+static void make_comments(string &text, long i)
+{
+    char line[256];
+    snprintf(line, sizeof(line),
+             "{ Comment number %ld explains the next line. }\n"
+             "x := %ld; // and this one trails it\n"
+             "/* A block comment\n   spanning two lines. */\n",
+             i, i);
+    text += line;
+}
+
+
+/* Real literals in all notations. */
+static void make_reals(string &text, long i)
+{
+    char line[128];
+    snprintf(line, sizeof(line),
+             "r := %ld.25 * 1.5E-3 + .%ld - %lde2 / 0.%ld5e+1;\n",
+             i, i, i % 100, i);
+    text += line;
+}
+
+
+/* Scan about size bytes made by repeatedly calling make, and print the
+   result line. */
+static void bench_scan(const char *name, long size,
+                       void (*make)(string &, long))
+{
+    extern FILE *yyin;
+    extern int yylex();
+    extern void open_source(FILE *, const char *);
+    extern void close_source();
+
+    string text;
+    for (long i = 0; (long) text.size() < size; i++) {
+        make(text, i);
+    }
+
+    char path[] = "/tmp/scantestXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0 || write(fd, text.data(), text.size()) != (ssize_t) text.size()) {
+        perror(path);
+        exit(1);
+    }
+    close(fd);
+    // Scanning a mapped file leaves yyin NULL, so the file is kept here.
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror(path);
+        exit(1);
+    }
+
+    delete sym_tab;
+    sym_tab = new symbol_table();
+    yyin = file;
+    open_source(file, path);
+
+    long pool = sym_tab->pool_size();
+    long allocations = heap_allocations;
+    long count = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    while (yylex() != 0) {
+        count++;
+    }
+    chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+    double s = chrono::duration<double>(stop - start).count();
+
+    printf("%s,%ld,%ld,%.2f,%.0f,%ld,%ld\n", name, (long) text.size(),
+           count, text.size() / s / 1e6, count / s,
+           sym_tab->pool_size() - pool, heap_allocations - allocations);
+    fflush(stdout);
+
+    close_source();
+    fclose(file);
+    unlink(path);
+}
+
+
 /* Interactive scanner. We just parse whatever is typed in, and the token
-   type and corresponding yytext is printed. */
+   type and corresponding yytext is printed. With -b, the scanner is
+   benchmarked instead, see above. */
 int main(int argc, char **argv)
 {
     int     token;
     extern  FILE *yyin;
     extern  int yylex();
 
+    if (argc >= 2 && strcmp(argv[1], "-b") == 0) {
+        long size = 16 * 1024 * 1024;
+        if (argc > 3 || (argc == 3 && (size = atol(argv[2])) <= 0)) {
+            cerr << "Usage: " << argv[0] << " -b [ bytes ]\n";
+            exit(1);
+        }
+        printf("benchmark,bytes,tokens,mb_per_s,tokens_per_s,"
+               "pool_bytes,allocs\n");
+        bench_scan("identifiers", size, make_identifiers);
+        bench_scan("strings", size, make_strings);
+        bench_scan("comments", size, make_comments);
+        bench_scan("reals", size, make_reals);
+        exit(0);
+    }
+
     /* Open the input file, if any. */
     switch (argc) {
     case 1:
@@ -172,7 +328,8 @@ int main(int argc, char **argv)
         }
         break;
     default:
-        cerr << "Usage: " << argv[0] << " [ filename ]\n";
+        cerr << "Usage: " << argv[0] << " [ filename ]\n"
+             << "       " << argv[0] << " -b [ bytes ]\n";
         exit(1);
     }
 
@@ -0,0 +1,353 @@
+#include <iostream>
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "scanner.hh"
+#include "symtab.hh"
+
+using namespace std;
+
+/* Microbenchmarks for the symbol table. Each benchmark runs a synthetic
+   workload against a fresh symbol_table and prints one line of
+   comma-separated values:
+
+     benchmark,ops,ns_per_op,allocs_per_op,peak_bytes
+
+   ns_per_op is the wall clock time of the timed loop divided by ops.
+   allocs_per_op counts calls to operator new made inside the loop.
+   peak_bytes is the highest amount of heap memory in use during the loop,
+   counted from what was in use when it started. Table setup and the
+   generation of names are not timed. */
+
+YYSTYPE yylval;
+YYLTYPE yylloc;
+
+
+/*** Allocation counting. ***/
+
+static long heap_allocations = 0;
+static long heap_live = 0;
+static long heap_peak = 0;
+
+// Each block is prefixed with its size so that delete can count it.
+static const size_t HEADER = alignof(max_align_t);
+
+void *operator new(size_t size)
+{
+    char *p = (char *) malloc(size + HEADER);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    *(size_t *) p = size;
+    heap_allocations++;
+    heap_live += size;
+    if (heap_live > heap_peak) {
+        heap_peak = heap_live;
+    }
+    return p + HEADER;
+}
+
+
+void operator delete(void *p) noexcept
+{
+    if (p == NULL) {
+        return;
+    }
+    char *block = (char *) p - HEADER;
+    heap_live -= *(size_t *) block;
+    free(block);
+}
+
+
+
+/*** Measurement. ***/
+
+class measurement
+{
+private:
+    const char *name;
+    long allocations;
+    long live;
+    chrono::steady_clock::time_point start;
+
+public:
+    // Starts measuring. Call right before the timed loop.
+    measurement(const char *n) : name(n) {
+        allocations = heap_allocations;
+        live = heap_live;
+        heap_peak = heap_live;
+        start = chrono::steady_clock::now();
+    }
+
+    // Stops measuring and prints the result line for ops operations.
+    void report(long ops) {
+        chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+        double ns = chrono::duration<double, nano>(stop - start).count();
+        printf("%s,%ld,%.2f,%.3f,%ld\n", name, ops, ns / ops,
+               (double) (heap_allocations - allocations) / ops,
+               heap_peak - live);
+        fflush(stdout);
+    }
+};
+
+
+/* Returns count distinct identifiers made from the prefix, in one buffer
+   that is never freed. */
+static char **make_names(const char *prefix, long count)
+{
+    char **names = (char **) malloc(count * sizeof(char *));
+    char *buffer = (char *) malloc(count * 32);
+    for (long i = 0; i < count; i++) {
+        names[i] = buffer + i * 32;
+        snprintf(names[i], 32, "%s%ld", prefix, i);
+    }
+    return names;
+}
+
+
+/* Replace the global symbol table with an empty one, opened at the level
+   of a program block like the parser does. */
+static void fresh_table()
+{
+    delete sym_tab;
+    sym_tab = new symbol_table();
+    position_information pos;
+    sym_tab->enter_procedure(pos, sym_tab->pool_install((char *) "BENCH"));
+    sym_tab->open_scope();
+}
+
+
+
+/*** Benchmarks. ***/
+
+/* Install n names that are all new to the pool. */
+static void bench_pool_install_unique(long n)
+{
+    char **names = make_names("U", n);
+    fresh_table();
+
+    measurement m("pool_install_unique");
+    for (long i = 0; i < n; i++) {
+        sym_tab->pool_install(names[i]);
+    }
+    m.report(n);
+}
+
+
+/* Install the same 1024 names over and over; all but the first round find
+   the existing entry. */
+static void bench_pool_install_existing(long n)
+{
+    const long distinct = 1024;
+    char **names = make_names("E", distinct);
+    fresh_table();
+    for (long i = 0; i < distinct; i++) {
+        sym_tab->pool_install(names[i]);
+    }
+
+    measurement m("pool_install_existing");
+    for (long i = 0; i < n; i++) {
+        sym_tab->pool_install(names[i % distinct]);
+    }
+    m.report(n);
+}
+
+
+/* Declare n distinct variables in a single block. */
+static void bench_install_symbol_unique(long n)
+{
+    char **names = make_names("V", n);
+    fresh_table();
+    pool_index *ids = new pool_index[n];
+    for (long i = 0; i < n; i++) {
+        ids[i] = sym_tab->pool_install(names[i]);
+    }
+
+    measurement m("install_symbol_unique");
+    for (long i = 0; i < n; i++) {
+        sym_tab->install_symbol(ids[i], SYM_VAR);
+    }
+    m.report(n);
+    delete[] ids;
+}
+
+
+/* Look up n names, spread over 4096 variables in one block. */
+static void bench_lookup_symbol_hit(long n)
+{
+    const long distinct = 4096;
+    char **names = make_names("H", distinct);
+    fresh_table();
+    pool_index *ids = new pool_index[distinct];
+    for (long i = 0; i < distinct; i++) {
+        ids[i] = sym_tab->pool_install(names[i]);
+        sym_tab->enter_variable(ids[i], integer_type);
+    }
+
+    measurement m("lookup_symbol_hit");
+    for (long i = 0; i < n; i++) {
+        sym_tab->lookup_symbol(ids[(i * 7) % distinct]);
+    }
+    m.report(n);
+    delete[] ids;
+}
+
+
+/* Look up n names that are in the pool but not declared anywhere. */
+static void bench_lookup_symbol_miss(long n)
+{
+    const long distinct = 4096;
+    char **declared = make_names("D", distinct);
+    char **missing = make_names("M", distinct);
+    fresh_table();
+    pool_index *ids = new pool_index[distinct];
+    for (long i = 0; i < distinct; i++) {
+        sym_tab->enter_variable(sym_tab->pool_install(declared[i]),
+                                integer_type);
+        ids[i] = sym_tab->pool_install(missing[i]);
+    }
+
+    measurement m("lookup_symbol_miss");
+    for (long i = 0; i < n; i++) {
+        sym_tab->lookup_symbol(ids[(i * 7) % distinct]);
+    }
+    m.report(n);
+    delete[] ids;
+}
+
+
+/* Heavy shadowing: the same 16 names are redeclared in each of 64 nested
+   blocks, and a name declared only in the outermost block is looked up
+   among them as often as the shadowed ones. */
+static void bench_lookup_symbol_shadowed(long n)
+{
+    const long distinct = 16;
+    const long depth = 64;
+    char **names = make_names("S", distinct);
+    fresh_table();
+    pool_index outer = sym_tab->pool_install((char *) "OUTER");
+    sym_tab->enter_variable(outer, integer_type);
+    pool_index *ids = new pool_index[distinct];
+    for (long i = 0; i < distinct; i++) {
+        ids[i] = sym_tab->pool_install(names[i]);
+    }
+    position_information pos;
+    pool_index block = sym_tab->pool_install((char *) "BLOCK");
+    for (long d = 0; d < depth; d++) {
+        sym_tab->enter_procedure(pos, block);
+        sym_tab->open_scope();
+        for (long i = 0; i < distinct; i++) {
+            sym_tab->enter_variable(ids[i], integer_type);
+        }
+    }
+
+    measurement m("lookup_symbol_shadowed");
+    for (long i = 0; i < n; i++) {
+        sym_tab->lookup_symbol(i & 1 ? outer : ids[(i / 2) % distinct]);
+    }
+    m.report(n);
+    delete[] ids;
+}
+
+
+/* Open and close blocks nested 64 deep, each declaring 8 variables. One
+   op is one open_scope()/close_scope() pair including its declarations.
+   Every nest gets an outermost block of its own name, so that nothing is
+   redeclared. With reclaim set, each closed scope is reclaimed as with the
+   compiler's -r flag. */
+static void bench_scope_nesting(long n, bool reclaim)
+{
+    const long depth = 64;
+    const long locals = 8;
+    const long rounds = (n + depth - 1) / depth;
+    char **names = make_names("L", locals);
+    char **blocks = make_names("B", rounds);
+    fresh_table();
+    pool_index *ids = new pool_index[locals];
+    for (long i = 0; i < locals; i++) {
+        ids[i] = sym_tab->pool_install(names[i]);
+    }
+    pool_index *block_ids = new pool_index[rounds];
+    for (long r = 0; r < rounds; r++) {
+        block_ids[r] = sym_tab->pool_install(blocks[r]);
+    }
+    position_information pos;
+
+    measurement m(reclaim ? "scope_nesting_reclaim" : "scope_nesting");
+    long ops = 0;
+    for (long r = 0; r < rounds; r++) {
+        for (long d = 0; d < depth; d++) {
+            sym_tab->enter_procedure(pos, block_ids[r]);
+            sym_tab->open_scope();
+            for (long i = 0; i < locals; i++) {
+                sym_tab->enter_variable(ids[i], integer_type);
+            }
+        }
+        for (long d = 0; d < depth; d++) {
+            sym_tab->close_scope();
+            if (reclaim) {
+                sym_tab->reclaim_closed_scope(false);
+            }
+        }
+        ops += depth;
+    }
+    m.report(ops);
+    delete[] ids;
+    delete[] block_ids;
+}
+
+
+/* Generate temporaries in blocks of 256, as quad generation does for a
+   large procedure. */
+static void bench_gen_temp_var(long n)
+{
+    const long per_block = 256;
+    const long rounds = (n + per_block - 1) / per_block;
+    char **blocks = make_names("T", rounds);
+    fresh_table();
+    pool_index *block_ids = new pool_index[rounds];
+    for (long r = 0; r < rounds; r++) {
+        block_ids[r] = sym_tab->pool_install(blocks[r]);
+    }
+    position_information pos;
+
+    measurement m("gen_temp_var");
+    long ops = 0;
+    for (long r = 0; r < rounds; r++) {
+        sym_tab->enter_procedure(pos, block_ids[r]);
+        sym_tab->open_scope();
+        for (long i = 0; i < per_block; i++) {
+            sym_tab->gen_temp_var(i & 1 ? real_type : integer_type);
+        }
+        sym_tab->close_scope();
+        ops += per_block;
+    }
+    m.report(ops);
+    delete[] block_ids;
+}
+
+
+int main(int argc, char **argv)
+{
+    long n = 100000;
+
+    if (argc > 2 || (argc == 2 && (n = atol(argv[1])) <= 0)) {
+        cerr << "Usage: " << argv[0] << " [operations]" << endl;
+        return 1;
+    }
+
+    printf("benchmark,ops,ns_per_op,allocs_per_op,peak_bytes\n");
+    bench_pool_install_unique(n);
+    bench_pool_install_existing(n);
+    bench_install_symbol_unique(n);
+    bench_lookup_symbol_hit(n);
+    bench_lookup_symbol_miss(n);
+    bench_lookup_symbol_shadowed(n);
+    bench_scope_nesting(n, false);
+    bench_scope_nesting(n, true);
+    bench_gen_temp_var(n);
+
+    return 0;
+}
@@ -15,7 +15,7 @@ YYLTYPE yylloc;
 
 int main(int argc, char **argv) {
     // This is just a dummy position for the preinstalled functions.
-    position_information *pos = new position_information();
+    position_information pos;
 
     if (argc != 2 || strlen(argv[1]) != 1 || *argv[1] < 'a' || *argv[1] > 'c') {
       cerr << "Usage: " << argv[0] << " [a|b|c]" << endl;